@@ -0,0 +1,48 @@
+///
+/// @file   bench_options.hpp
+/// @brief  Command-line option parsing shared by the benchmark
+///         programs, options have the form --option=value.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef BENCH_OPTIONS_HPP
+#define BENCH_OPTIONS_HPP
+
+#include "primecount.hpp"
+
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+/// Returns the value of --option=value or an
+/// empty string if arg is not --option.
+///
+std::string get_value(const std::string& arg, const std::string& option)
+{
+  std::string prefix = option + "=";
+  if (arg.compare(0, prefix.size(), prefix) == 0)
+    return arg.substr(prefix.size());
+  else
+    return std::string();
+}
+
+/// Parse the value of --option=N.
+/// Throws a primecount_error unless N >= 1.
+///
+int to_int(const std::string& str, const std::string& option)
+{
+  char* end;
+  long n = std::strtol(str.c_str(), &end, 10);
+  if (str.empty() || *end != '\0' || n < 1)
+    throw primecount::primecount_error("invalid option " + option + "=" + str);
+  return (int) n;
+}
+
+} // namespace
+
+#endif
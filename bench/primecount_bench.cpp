@@ -0,0 +1,256 @@
+///
+/// @file   primecount_bench.cpp
+/// @brief  Benchmark the individual formulas of primecount's
+///         prime counting algorithms and the construction of its
+///         lookup tables. Each benchmark of the fixed input matrix
+///         is run multiple times and the median, mean, variance,
+///         minimum and maximum of the run times are printed in
+///         JSON format. Comparing the JSON files of 2 builds
+///         allows to detect performance regressions per formula,
+///         whereas scripts/benchmark-vs-prev-release.sh only
+///         measures the run time of the entire computation.
+///
+///         Usage: primecount_bench [--iterations=N] [--threads=N]
+///                                 [--output=FILE]
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "primecount.hpp"
+#include "primecount-internal.hpp"
+#include "FactorTableD.hpp"
+#include "PiTable.hpp"
+#include "gourdon.hpp"
+#include "print.hpp"
+#include "S.hpp"
+#include "bench_options.hpp"
+
+#include <stdint.h>
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace primecount;
+
+namespace {
+
+struct Benchmark
+{
+  std::string name;
+  std::string input;
+  std::function<int64_t()> compute;
+};
+
+struct Stats
+{
+  double median;
+  double mean;
+  double variance;
+  double min;
+  double max;
+};
+
+/// The fixed input matrix, on a single thread
+/// each run takes between a few milliseconds
+/// and about 1 second on a recent x64 CPU.
+///
+std::vector<Benchmark> get_benchmarks(int threads)
+{
+  std::vector<Benchmark> benchmarks;
+
+  for (int64_t x : { (int64_t) 1e13, (int64_t) 1e15 })
+  {
+    std::string input = "x=" + std::to_string(x);
+    GourdonVars v = get_gourdon_vars(x);
+
+    benchmarks.push_back({"Sigma", input, [=] { return Sigma(x, v.y, threads); }});
+    benchmarks.push_back({"Phi0", input, [=] { return Phi0(x, v.y, v.z, v.k, threads); }});
+    benchmarks.push_back({"AC", input, [=] { return AC(x, v.y, v.z, v.k, threads); }});
+    benchmarks.push_back({"B", input, [=] { return B(x, v.y, threads); }});
+    benchmarks.push_back({"D", input, [=] { return D(x, v.y, v.z, v.k, Li(x), threads); }});
+  }
+
+  for (int64_t x : { (int64_t) 1e13, (int64_t) 1e14 })
+  {
+    std::string input = "x=" + std::to_string(x);
+    DelegliseRivatVars v = get_deleglise_rivat_vars(x);
+    int64_t a = pi_noprint(v.y, threads);
+
+    benchmarks.push_back({"S2_easy", input, [=] { return S2_easy(x, v.y, v.z, v.c, threads); }});
+    benchmarks.push_back({"S2_hard", input, [=] { return S2_hard(x, v.y, v.z, v.c, Li(x), threads); }});
+    benchmarks.push_back({"P2", input, [=] { return P2(x, v.y, a, threads); }});
+  }
+
+  for (int64_t a : { 1000, 100000 })
+  {
+    int64_t x = (int64_t) 1e13;
+    std::string input = "x=" + std::to_string(x) + ",a=" + std::to_string(a);
+    benchmarks.push_back({"phi", input, [=] { return phi(x, a, threads); }});
+  }
+
+  for (int64_t limit : { (int64_t) 1e8, (int64_t) 1e9 })
+  {
+    std::string input = "limit=" + std::to_string(limit);
+    benchmarks.push_back({"PiTable", input, [=] {
+      PiTable pi(limit, threads);
+      return (int64_t) pi[limit];
+    }});
+  }
+
+  for (int64_t x : { (int64_t) 1e16, (int64_t) 1e18 })
+  {
+    GourdonVars v = get_gourdon_vars(x);
+    std::string input = "y=" + std::to_string(v.y) + ",z=" + std::to_string(v.z);
+    benchmarks.push_back({"FactorTableD", input, [=] {
+      FactorTableD<uint16_t> factor(v.y, v.z, threads);
+      return factor.is_leaf(factor.to_index(v.z));
+    }});
+  }
+
+  for (int64_t n : { (int64_t) 1e10, (int64_t) 1e12 })
+  {
+    std::string input = "n=" + std::to_string(n);
+    benchmarks.push_back({"nth_prime", input, [=] { return nth_prime(n, threads); }});
+  }
+
+  return benchmarks;
+}
+
+Stats get_stats(std::vector<double> seconds)
+{
+  std::sort(seconds.begin(), seconds.end());
+  std::size_t n = seconds.size();
+
+  Stats stats;
+  stats.min = seconds.front();
+  stats.max = seconds.back();
+  stats.median = (n % 2) ? seconds[n / 2] : (seconds[n / 2 - 1] + seconds[n / 2]) / 2;
+  stats.mean = 0;
+  stats.variance = 0;
+
+  for (double s : seconds)
+    stats.mean += s;
+  stats.mean /= n;
+
+  // Sample variance
+  if (n > 1)
+  {
+    for (double s : seconds)
+      stats.variance += (s - stats.mean) * (s - stats.mean);
+    stats.variance /= n - 1;
+  }
+
+  return stats;
+}
+
+/// Run each benchmark of the input matrix iterations times
+/// and print the statistics of the run times in seconds.
+/// A benchmark fails if its result differs between runs.
+///
+std::string run(int iterations, int threads)
+{
+  std::vector<Benchmark> benchmarks = get_benchmarks(threads);
+  std::ostringstream json;
+  json << std::setprecision(6);
+  json << "{\n";
+  json << "  \"primecount_version\": \"" << primecount_version() << "\",\n";
+  json << "  \"threads\": " << threads << ",\n";
+  json << "  \"iterations\": " << iterations << ",\n";
+  json << "  \"benchmarks\": [\n";
+
+  for (std::size_t i = 0; i < benchmarks.size(); i++)
+  {
+    const Benchmark& bench = benchmarks[i];
+    std::vector<double> seconds;
+    int64_t result = 0;
+
+    for (int j = 0; j < iterations; j++)
+    {
+      double time = get_time();
+      int64_t res = bench.compute();
+      seconds.push_back(get_time() - time);
+
+      if (j > 0 && res != result)
+        throw primecount_error(bench.name + "(" + bench.input + "): result differs between runs");
+      result = res;
+    }
+
+    Stats stats = get_stats(seconds);
+    std::cerr << bench.name << "(" << bench.input << "): "
+              << std::fixed << std::setprecision(3)
+              << stats.median << " seconds" << std::endl;
+
+    json << "    {\n";
+    json << "      \"name\": \"" << bench.name << "\",\n";
+    json << "      \"input\": \"" << bench.input << "\",\n";
+    json << "      \"result\": " << result << ",\n";
+    json << "      \"median\": " << stats.median << ",\n";
+    json << "      \"mean\": " << stats.mean << ",\n";
+    json << "      \"variance\": " << stats.variance << ",\n";
+    json << "      \"min\": " << stats.min << ",\n";
+    json << "      \"max\": " << stats.max << "\n";
+    json << "    }" << (i + 1 < benchmarks.size() ? "," : "") << "\n";
+  }
+
+  json << "  ]\n";
+  json << "}\n";
+
+  return json.str();
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  try
+  {
+    int iterations = 5;
+    int threads = get_num_threads();
+    std::string output;
+
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      std::string value;
+
+      if (!(value = get_value(arg, "--iterations")).empty())
+        iterations = to_int(value, "--iterations");
+      else if (!(value = get_value(arg, "--threads")).empty())
+        threads = to_int(value, "--threads");
+      else if (!(value = get_value(arg, "--output")).empty())
+        output = value;
+      else
+        throw primecount_error("unrecognized option " + arg + "\n"
+                               "Usage: primecount_bench [--iterations=N] [--threads=N] [--output=FILE]");
+    }
+
+    set_print(false);
+    std::string json = run(iterations, threads);
+
+    if (output.empty())
+      std::cout << json;
+    else
+    {
+      std::ofstream file(output);
+      file << json;
+      if (!file)
+        throw primecount_error("failed to write " + output);
+    }
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "primecount_bench: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,355 @@
+///
+/// @file   sieve_bench.cpp
+/// @brief  Microbenchmark of the Sieve class which is used to
+///         compute the hard special leaves in D(x, y) and
+///         S2_hard(x, y). The Sieve is driven exactly like in
+///         D_thread() (see src/gourdon/D.cpp): the segment size is
+///         the same as in LoadBalancerS2 and the leaves, i.e. the
+///         Sieve::count(stop) queries, are those of a real D(x, y)
+///         computation. The leaves are generated once and then
+///         replayed multiple times:
+///
+///         1) Sieve::pre_sieve() only.
+///         2) 1) + Sieve::cross_off_count().
+///         3) 2) + Sieve::count(stop) for each leaf.
+///
+///         The differences of the median run times divided by the
+///         number of crossed off multiples and the number of leaves
+///         give the nanoseconds per cross-off and per count() call.
+///
+///         Usage: sieve_bench [--iterations=N] [--output=FILE]
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "primecount.hpp"
+#include "primecount-internal.hpp"
+#include "primecount-config.hpp"
+#include "FactorTableD.hpp"
+#include "PiTable.hpp"
+#include "Sieve.hpp"
+#include "fast_div.hpp"
+#include "generate.hpp"
+#include "imath.hpp"
+#include "min.hpp"
+#include "pod_vector.hpp"
+#include "bench_options.hpp"
+
+#include <stdint.h>
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace primecount;
+
+namespace {
+
+/// Stop recording leaves once this limit has been
+/// reached, this bounds the memory usage.
+const uint64_t max_leaves = 1 << 22;
+const int64_t max_segments = 64;
+
+/// Leaves of the segment [low, high[ of D_thread(). The
+/// leaves of the b-th sieving prime end at
+/// stops[b_end[b - min_b]].
+///
+struct SegmentLeaves
+{
+  int64_t low;
+  int64_t high;
+  int64_t max_b;
+  std::vector<std::size_t> b_end;
+};
+
+struct Workload
+{
+  std::string input;
+  int64_t x;
+  int64_t y;
+  int64_t low;
+  int64_t segment_size;
+  int64_t min_b;
+  int64_t max_b;
+  uint64_t cross_offs = 0;
+  std::vector<SegmentLeaves> segments;
+  std::vector<uint32_t> stops;
+};
+
+/// Number of integers inside [1, n] that
+/// are coprime to 2, 3 and 5.
+///
+uint64_t coprime30(uint64_t n)
+{
+  uint64_t count = (n / 30) * 8;
+  for (uint64_t i = n - n % 30 + 1; i <= n; i++)
+    count += (i % 2 != 0 && i % 3 != 0 && i % 5 != 0);
+  return count;
+}
+
+/// Record the leaves of D_thread() for the thread
+/// interval [low, low + segments * segment_size[ with
+/// the largest segment size used by LoadBalancerS2.
+/// @low_percent: low = xz * low_percent / 100
+///
+Workload record_leaves(int64_t x, int64_t low_percent)
+{
+  GourdonVars v = get_gourdon_vars(x);
+  int64_t y = v.y;
+  int64_t z = v.z;
+  int64_t k = v.k;
+  int64_t xz = x / z;
+  int64_t x_star = get_x_star_gourdon(x, y);
+
+  int64_t sieve_bytes = L1D_CACHE_SIZE * 2;
+  int64_t segment_size = max(sieve_bytes * 30, isqrt(xz));
+  segment_size = Sieve::get_segment_size(segment_size);
+
+  Workload w;
+  w.x = x;
+  w.y = y;
+  w.segment_size = segment_size;
+  w.low = (xz / 100 * low_percent) / segment_size * segment_size;
+  w.input = "x=" + std::to_string(x) + ",low=" + std::to_string(w.low) +
+            ",segment_size=" + std::to_string(segment_size);
+
+  auto primes = generate_primes<int32_t>(y);
+  PiTable pi(y, 1);
+  FactorTableD<uint16_t> factor(y, z, 1);
+
+  int64_t low = w.low;
+  int64_t low1 = max(low, 1);
+  int64_t pi_sqrtz = pi[isqrt(z)];
+  int64_t limit = min(low + max_segments * segment_size, xz);
+  int64_t max_b = pi[min3(isqrt(x / low1), isqrt(limit), x_star)];
+  int64_t min_b = pi[min(xz / limit, x_star)];
+  min_b = max(k, min_b) + 1;
+  w.min_b = min_b;
+  w.max_b = max_b;
+
+  for (; low < limit && w.stops.size() < max_leaves; low += segment_size)
+  {
+    int64_t high = min(low + segment_size, limit);
+    low1 = max(low, 1);
+    SegmentLeaves segment;
+    segment.low = low;
+    segment.high = high;
+    int64_t b = min_b;
+
+    // Same as D_thread(), composite leaves
+    for (int64_t last = min(pi_sqrtz, max_b); b <= last; b++)
+    {
+      int64_t prime = primes[b];
+      int64_t xp = x / prime;
+      int64_t xp_low = min(xp / low1, z);
+      int64_t xp_high = min(xp / high, z);
+      int64_t min_m = max(xp_high, z / prime);
+      int64_t max_m = min(xp / (prime * prime), xp_low);
+
+      if (prime >= max_m)
+        goto next_segment;
+
+      min_m = factor.to_index(min_m);
+      max_m = factor.to_index(max_m);
+      int64_t leaf_key = factor.leaf_key(b);
+
+      for (int64_t m = max_m; m > min_m; m--)
+        if (leaf_key < factor.is_leaf(m))
+          w.stops.push_back((uint32_t) (xp / factor.to_number(m) - low));
+
+      segment.b_end.push_back(w.stops.size());
+      w.cross_offs += coprime30((high - 1) / prime) - coprime30(low / prime);
+    }
+
+    // Same as D_thread(), leaves composed of 2 primes
+    for (; b <= max_b; b++)
+    {
+      int64_t prime = primes[b];
+      int64_t xp = x / prime;
+      int64_t xp_low = min(xp / low1, y);
+      int64_t xp_high = min(xp / high, y);
+      int64_t min_m = max(xp_high, prime);
+      int64_t max_m = min(xp / (prime * prime), xp_low);
+      int64_t l = pi[max_m];
+
+      if (prime >= primes[l])
+        goto next_segment;
+
+      for (; primes[l] > min_m; l--)
+        w.stops.push_back((uint32_t) (xp / primes[l] - low));
+
+      segment.b_end.push_back(w.stops.size());
+      w.cross_offs += coprime30((high - 1) / prime) - coprime30(low / prime);
+    }
+
+    next_segment:;
+    segment.max_b = b - 1;
+    w.segments.push_back(segment);
+  }
+
+  return w;
+}
+
+/// Replay the recorded leaves.
+/// mode 0: pre_sieve() only.
+/// mode 1: pre_sieve() + cross_off_count().
+/// mode 2: pre_sieve() + cross_off_count() + count(stop).
+///
+uint64_t replay(const Workload& w,
+                const pod_vector<int32_t>& primes,
+                int mode)
+{
+  uint64_t sum = 0;
+  Sieve sieve(w.low, w.segment_size, w.max_b);
+  std::size_t i = 0;
+
+  for (const SegmentLeaves& segment : w.segments)
+  {
+    sieve.pre_sieve(primes, w.min_b - 1, segment.low, segment.high);
+    if (mode == 0)
+      continue;
+
+    for (int64_t b = w.min_b; b <= segment.max_b; b++)
+    {
+      std::size_t end = segment.b_end[b - w.min_b];
+      if (mode == 2)
+        for (; i < end; i++)
+          sum += sieve.count(w.stops[i]);
+
+      sum += sieve.get_total_count();
+      sieve.cross_off_count(primes[b], b);
+    }
+  }
+
+  return sum;
+}
+
+double median_seconds(const Workload& w,
+                      const pod_vector<int32_t>& primes,
+                      int mode,
+                      int iterations,
+                      uint64_t& result)
+{
+  std::vector<double> seconds;
+
+  for (int i = 0; i < iterations; i++)
+  {
+    double time = get_time();
+    uint64_t res = replay(w, primes, mode);
+    seconds.push_back(get_time() - time);
+
+    if (i > 0 && res != result)
+      throw primecount_error("sieve_bench: result differs between runs");
+    result = res;
+  }
+
+  std::sort(seconds.begin(), seconds.end());
+  std::size_t n = seconds.size();
+  return (n % 2) ? seconds[n / 2] : (seconds[n / 2 - 1] + seconds[n / 2]) / 2;
+}
+
+std::string run(int iterations)
+{
+  std::ostringstream json;
+  json << std::setprecision(6);
+  json << "{\n";
+  json << "  \"primecount_version\": \"" << primecount_version() << "\",\n";
+  json << "  \"iterations\": " << iterations << ",\n";
+  json << "  \"benchmarks\": [\n";
+
+  std::vector<std::pair<int64_t, int64_t>> inputs =
+  {
+    { (int64_t) 1e14, 0 }, { (int64_t) 1e14, 10 },
+    { (int64_t) 1e16, 0 }, { (int64_t) 1e16, 10 },
+    { (int64_t) 1e18, 0 }, { (int64_t) 1e18, 10 }
+  };
+
+  for (std::size_t i = 0; i < inputs.size(); i++)
+  {
+    Workload w = record_leaves(inputs[i].first, inputs[i].second);
+    auto primes = generate_primes<int32_t>(w.y);
+    uint64_t res0 = 0, res1 = 0, res2 = 0;
+
+    double t0 = median_seconds(w, primes, 0, iterations, res0);
+    double t1 = median_seconds(w, primes, 1, iterations, res1);
+    double t2 = median_seconds(w, primes, 2, iterations, res2);
+
+    uint64_t counts = w.stops.size();
+    double ns_cross_off = std::max(t1 - t0, 0.0) * 1e9 / std::max<uint64_t>(w.cross_offs, 1);
+    double ns_count = std::max(t2 - t1, 0.0) * 1e9 / std::max<uint64_t>(counts, 1);
+
+    std::cerr << "Sieve(" << w.input << "): "
+              << std::fixed << std::setprecision(2)
+              << ns_cross_off << " ns/cross-off, "
+              << ns_count << " ns/count" << std::endl;
+
+    json << "    {\n";
+    json << "      \"input\": \"" << w.input << "\",\n";
+    json << "      \"segments\": " << w.segments.size() << ",\n";
+    json << "      \"sieving_primes\": " << w.max_b - w.min_b + 1 << ",\n";
+    json << "      \"cross_offs\": " << w.cross_offs << ",\n";
+    json << "      \"count_calls\": " << counts << ",\n";
+    json << "      \"pre_sieve_seconds\": " << t0 << ",\n";
+    json << "      \"cross_off_count_seconds\": " << t1 - t0 << ",\n";
+    json << "      \"count_seconds\": " << t2 - t1 << ",\n";
+    json << "      \"ns_per_cross_off\": " << ns_cross_off << ",\n";
+    json << "      \"ns_per_count\": " << ns_count << "\n";
+    json << "    }" << (i + 1 < inputs.size() ? "," : "") << "\n";
+  }
+
+  json << "  ]\n";
+  json << "}\n";
+
+  return json.str();
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  try
+  {
+    int iterations = 5;
+    std::string output;
+
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      std::string value;
+
+      if (!(value = get_value(arg, "--iterations")).empty())
+        iterations = to_int(value, "--iterations");
+      else if (!(value = get_value(arg, "--output")).empty())
+        output = value;
+      else
+        throw primecount_error("unrecognized option " + arg + "\n"
+                               "Usage: sieve_bench [--iterations=N] [--output=FILE]");
+    }
+
+    std::string json = run(iterations);
+
+    if (output.empty())
+      std::cout << json;
+    else
+    {
+      std::ofstream file(output);
+      file << json;
+      if (!file)
+        throw primecount_error("failed to write " + output);
+    }
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "sieve_bench: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -26,7 +26,7 @@ if(OpenMP_FOUND OR OpenMP_CXX_FOUND)
 
     # Check if compiles without libatomic
     check_cxx_source_compiles("
-        #include "int128_t.hpp"
+        #include \"int128_t.hpp\"
         #include <omp.h>
         #include <stdint.h>
         #include <iostream>
@@ -51,7 +51,7 @@ if(OpenMP_FOUND OR OpenMP_CXX_FOUND)
 
             # Check if compiles with libatomic
             check_cxx_source_compiles("
-                #include "int128_t.hpp"
+                #include \"int128_t.hpp\"
                 #include <omp.h>
                 #include <stdint.h>
                 #include <iostream>
@@ -90,13 +90,7 @@ if(OpenMP_FOUND OR OpenMP_CXX_FOUND)
     endif()
 endif()
 
-# OpenMP test has failed, print warning message
+# OpenMP test has failed, primecount uses std::thread instead
 if(NOT OpenMP AND NOT OpenMP_with_libatomic)
-    if (CMAKE_CXX_COMPILER_ID MATCHES "Clang|LLVM")
-        message(WARNING "Install the OpenMP library (libomp) to enable multithreading in primecount!")
-    elseif (CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
-        message(WARNING "Install the OpenMP library (libgomp) to enable multithreading in primecount!")
-    else()
-        message(WARNING "Install the OpenMP library to enable multithreading in primecount!")
-    endif()
+    message(STATUS "OpenMP not found, using std::thread for multithreading")
 endif()
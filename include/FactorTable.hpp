@@ -51,11 +51,14 @@
 #include "imath.hpp"
 #include "int128_t.hpp"
 #include "macros.hpp"
+#include "parallel.hpp"
 #include "pod_vector.hpp"
+#include "TableCache.hpp"
 
 #include <algorithm>
 #include <limits>
 #include <stdint.h>
+#include <string>
 
 namespace {
 
@@ -73,7 +76,20 @@ public:
 
     y = std::max<int64_t>(1, y);
     T T_MAX = std::numeric_limits<T>::max();
-    factor_.resize(to_index(y) + 1);
+    int64_t size = to_index(y) + 1;
+    std::string name = "FactorTable" + std::to_string(sizeof(T) * 8) + ".bin";
+    TableHeader header(2310, sizeof(T), y, size);
+
+    // Map FactorTable from the table cache directory
+    if (is_table_cache(y))
+    {
+      table_ = (const T*) file_.open(name, header);
+      if (table_)
+        return;
+    }
+
+    factor_.resize(size);
+    table_ = factor_.data();
 
     // mu(1) = 1.
     // 1 has zero prime factors, hence 1 has an even
@@ -88,8 +104,7 @@ public:
     int64_t thread_distance = ceil_div(y, threads);
     thread_distance += coprime_indexes_.size() - thread_distance % coprime_indexes_.size();
 
-    #pragma omp parallel for num_threads(threads)
-    for (int t = 0; t < threads; t++)
+    parallel_region(threads, [&](int t)
     {
       // Thread processes interval [low, high]
       int64_t low = thread_distance * t;
@@ -145,7 +160,10 @@ public:
           }
         }
       }
-    }
+    });
+
+    if (is_table_cache(y))
+      table_ = file_.save(name, header, factor_);
   }
 
   /// mu_lpf(n) is a combination of the mu(n) (Möbius function)
@@ -160,7 +178,7 @@ public:
   ///
   int64_t mu_lpf(int64_t index) const
   {
-    return factor_[index];
+    return table_[index];
   }
 
   /// Get the Möbius function value of the number
@@ -176,13 +194,13 @@ public:
     // mu(n) = 0 is disabled by default for performance
     // reasons, we only enable it for testing.
     #if defined(ENABLE_MU_0_TESTING)
-      if (factor_[index] == 0)
+      if (table_[index] == 0)
         return 0;
     #else
-      ASSERT(factor_[index] != 0);
+      ASSERT(table_[index] != 0);
     #endif
 
-    if (factor_[index] & 1)
+    if (table_[index] & 1)
       return -1;
     else
       return 1;
@@ -196,6 +214,8 @@ public:
 
 private:
   pod_vector<T> factor_;
+  TableFile file_;
+  const T* table_ = nullptr;
 };
 
 } // namespace
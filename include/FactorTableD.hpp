@@ -7,8 +7,8 @@
 ///        which are not divisible by 2, 3, 5, 7 and 11. The factor[n]
 ///        lookup table uses up to 28 times less memory than the
 ///        lpf[n], mpf[n] and mu[n] lookup tables! factor[n] uses only
-///        2 bytes per entry for 32-bit numbers and 4 bytes per entry
-///        for 64-bit numbers.
+///        2 bytes per entry for numbers <= 1.16 * 10^11 and 4 bytes
+///        per entry for larger numbers.
 ///
 ///        The factor table concept was devised and implemented by
 ///        Christian Bau in 2003. Note that Tomás Oliveira e Silva
@@ -20,12 +20,12 @@
 ///
 ///        What we store in the factor[n] lookup table:
 ///
-///        1) INT_MAX - 1  if n = 1
-///        2) INT_MAX      if n is a prime
-///        3) 0            if n has a prime factor > y
-///        4) 0            if moebius(n) = 0
-///        5) lpf - 1      if moebius(n) = 1
-///        6) lpf          if moebius(n) = -1
+///        1) INT_MAX - 1        if n = 1
+///        2) INT_MAX            if n is a prime
+///        3) 0                  if n has a prime factor > y
+///        4) 0                  if moebius(n) = 0
+///        5) pi(lpf) * 2        if moebius(n) = 1
+///        6) pi(lpf) * 2 + 1    if moebius(n) = -1
 ///
 ///        factor[1] = (INT_MAX - 1) because 1 contributes to the
 ///        sum of the ordinary leaves S1(x, a) in the
@@ -34,8 +34,13 @@
 ///        below used in the D(x, y) formula by the 2nd new if
 ///        statement which is obviously faster.
 ///
-///        * Old: if (mu[n] != 0 && lpf[n] > prime && mpf[n] <= y)
-///        * New: if (prime < factor[n])
+///        * Old: if (mu[n] != 0 && lpf[n] > primes[b] && mpf[n] <= y)
+///        * New: if (b * 2 + 1 < factor[n])
+///
+///        Storing pi(lpf) instead of lpf allows to use 2 bytes per
+///        entry for numbers up to 1.16 * 10^11 instead of 2^32 which
+///        halves the memory usage of the FactorTableD for the
+///        z values used when computing pi(x) with x >= 10^24.
 ///
 /// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
 ///
@@ -53,11 +58,15 @@
 #include "imath.hpp"
 #include "int128_t.hpp"
 #include "macros.hpp"
+#include "parallel.hpp"
 #include "pod_vector.hpp"
+#include "TableCache.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <stdint.h>
+#include <string>
 
 namespace {
 
@@ -77,7 +86,24 @@ public:
 
     z = std::max<int64_t>(1, z);
     T T_MAX = std::numeric_limits<T>::max();
-    factor_.resize(to_index(z) + 1);
+    int64_t size = to_index(z) + 1;
+    // FactorTableD depends on y, hence a table file can only
+    // be reused for the same y. We keep a single table file
+    // (of the most recent y) so that the size of the table
+    // cache directory remains bounded.
+    std::string name = "FactorTableD" + std::to_string(sizeof(T) * 8) + ".bin";
+    TableHeader header(2310, sizeof(T), z, size, y);
+
+    // Map FactorTableD from the table cache directory
+    if (is_table_cache(z))
+    {
+      table_ = (const T*) file_.open(name, header);
+      if (table_)
+        return;
+    }
+
+    factor_.resize(size);
+    table_ = factor_.data();
 
     // mu(1) = 1.
     // 1 has zero prime factors, hence 1 has an even
@@ -92,8 +118,7 @@ public:
     int64_t thread_distance = ceil_div(z, threads);
     thread_distance += coprime_indexes_.size() - thread_distance % coprime_indexes_.size();
 
-    #pragma omp parallel for num_threads(threads)
-    for (int t = 0; t < threads; t++)
+    parallel_region(threads, [&](int t)
     {
       // Thread processes interval [low, high]
       int64_t low = thread_distance * t;
@@ -111,6 +136,7 @@ public:
         int64_t start = first_coprime();
         int64_t stop = high / first_coprime();
         int64_t min_m = first_coprime() * first_coprime();
+        int64_t pi_prime = 5;
         primesieve::iterator it(start, stop);
 
         if (min_m <= high)
@@ -122,6 +148,7 @@ public:
             int64_t prime = it.next_prime();
             int64_t multiple = next_multiple(prime, low, &i);
             min_m = prime * first_coprime();
+            pi_prime++;
 
             if (min_m > high)
               break;
@@ -131,7 +158,7 @@ public:
               int64_t mi = to_index(multiple);
               // prime is the smallest factor of multiple
               if (factor_[mi] == T_MAX)
-                factor_[mi] = (T) prime;
+                factor_[mi] = (T) (pi_prime * 2 + 1);
               // the least significant bit indicates
               // whether multiple has an even (0) or odd (1)
               // number of prime factors
@@ -177,7 +204,10 @@ public:
           }
         }
       }
-    }
+    });
+
+    if (is_table_cache(z))
+      table_ = file_.save(name, header, factor_);
   }
 
   /// Returns true if n (with n = to_number(index)) is a
@@ -186,16 +216,26 @@ public:
   ///
   /// Return value:
   ///
-  /// 1) INT_MAX - 1  if n = 1
-  /// 2) INT_MAX      if n is a prime
-  /// 3) 0            if n has a prime factor > y
-  /// 4) 0            if moebius(n) = 0
-  /// 5) lpf - 1      if moebius(n) = 1
-  /// 6) lpf          if moebius(n) = -1
+  /// 1) INT_MAX - 1        if n = 1
+  /// 2) INT_MAX            if n is a prime
+  /// 3) 0                  if n has a prime factor > y
+  /// 4) 0                  if moebius(n) = 0
+  /// 5) pi(lpf) * 2        if moebius(n) = 1
+  /// 6) pi(lpf) * 2 + 1    if moebius(n) = -1
   ///
   int64_t is_leaf(int64_t index) const
   {
-    return factor_[index];
+    return table_[index];
+  }
+
+  /// n = to_number(index) is a hard special leaf of the b-th
+  /// prime if: leaf_key(b) < is_leaf(index).
+  /// This is identical to:
+  /// mu[n] != 0 && lpf[n] > primes[b] && mpf[n] <= y
+  ///
+  static int64_t leaf_key(int64_t b)
+  {
+    return b * 2 + 1;
   }
 
   /// Get the Möbius function value of the number
@@ -211,26 +251,35 @@ public:
     // mu(n) = 0 is disabled by default for performance
     // reasons, we only enable it for testing.
     #if defined(ENABLE_MU_0_TESTING)
-      if (factor_[index] == 0)
+      if (table_[index] == 0)
         return 0;
     #else
-      ASSERT(factor_[index] != 0);
+      ASSERT(table_[index] != 0);
     #endif
 
-    if (factor_[index] & 1)
+    if (table_[index] & 1)
       return -1;
     else
       return 1;
   }
 
+  /// Composite numbers n <= z have lpf[n] <= sqrt(z), hence
+  /// we must ensure that pi(sqrt(z)) * 2 + 1 < INT_MAX - 1.
+  /// We use the lower bound n * log(n) < nth_prime(n) [Rosser
+  /// 1939] in order to find the largest z that satisfies
+  /// pi(sqrt(z)) <= n - 1 with n = (INT_MAX - 1) / 2.
+  ///
   static maxint_t max()
   {
-    maxint_t T_MAX = std::numeric_limits<T>::max();
-    return ipow(T_MAX - 1, 2) - 1;
+    double n = (double) ((std::numeric_limits<T>::max() - 1) / 2);
+    maxint_t max_sqrtz = (maxint_t) (n * std::log(n));
+    return ipow(max_sqrtz, 2) - 1;
   }
 
 private:
   pod_vector<T> factor_;
+  TableFile file_;
+  const T* table_ = nullptr;
 };
 
 } // namespace
@@ -0,0 +1,113 @@
+///
+/// @file  IntervalSieve.hpp
+/// @brief Segmented sieve of Eratosthenes for intervals [low, high]
+///        whose bounds may be 128-bit integers. primesieve is
+///        limited to numbers < 2^64, the IntervalSieve is used to
+///        count and find primes in short intervals above 2^64.
+///
+///        Each segment is sieved using all sieving primes
+///        <= sqrt(high), hence sieving [low, high] costs
+///        O(high - low + segments * sqrt(high)) operations with
+///        segments = ceil((high - low) / segment_size()). Each
+///        thread sieves its own sub-interval of the segment using
+///        all sieving primes, the sieving primes are generated
+///        only once per segment and shared by all threads.
+///
+///        Near 10^29 there are about 10^13 sieving primes, hence
+///        even a short interval takes hours to sieve. Callers
+///        (nth_prime(n), count_primes(a, b)) therefore bound the
+///        number of segments to sieve and otherwise use pi(x).
+///
+///        Each bit of the sieve array corresponds to an integer
+///        that is not divisible by 2, 3 and 5. The 8 bits of each
+///        byte correspond to the offsets { 1, 7, 11, 13, 17, 19,
+///        23, 29 }. Since the sieve array uses the uint64_t data
+///        type, one array element (8 bytes) corresponds to an
+///        interval of size 30 * 8 = 240.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef INTERVALSIEVE_HPP
+#define INTERVALSIEVE_HPP
+
+#include "BitSieve240.hpp"
+#include "int128_t.hpp"
+#include "pod_vector.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+namespace primecount {
+
+class IntervalSieve : public BitSieve240
+{
+public:
+  IntervalSieve(int threads = 1);
+
+  /// Sieve the primes inside the segment [low, high].
+  /// @pre low > sqrt(high) and high - low < segment_size()
+  ///
+  void sieve(maxuint_t low, maxuint_t high);
+
+  /// Number of primes inside the segment
+  uint64_t count() const;
+
+  /// Number of primes inside [low, high]
+  /// @pre [low, high] is located inside the segment
+  ///
+  uint64_t count(maxuint_t low, maxuint_t high) const;
+
+  /// Returns the nth prime of the segment.
+  /// @pre 1 <= n <= count()
+  ///
+  maxuint_t nth_prime(uint64_t n) const;
+
+  /// Returns the nth prime of the segment counting downwards
+  /// i.e. nth_prime_desc(1) is the largest prime.
+  /// @pre 1 <= n <= count()
+  ///
+  maxuint_t nth_prime_desc(uint64_t n) const;
+
+  /// Each thread sieves at most 240 * 2^22 integers
+  /// at once, this uses 32 MiB of memory per thread.
+  ///
+  static constexpr uint64_t max_segment_size()
+  {
+    return 240ull << 22;
+  }
+
+  /// Maximum size of the segment [low, high]
+  uint64_t segment_size() const
+  {
+    return max_segment_size() * threads_;
+  }
+
+private:
+  struct SievingPrime
+  {
+    uint64_t prime;
+    uint64_t multiple;
+  };
+
+  void generate_primes(int thread_num, int threads, uint64_t start, uint64_t stop, uint64_t thread_size);
+  void cross_off(int thread_num, int threads, uint64_t thread_words);
+  maxuint_t get_prime(uint64_t i, uint64_t bit) const;
+  pod_vector<uint64_t> sieve_;
+  std::vector<pod_vector<SievingPrime>> primes_;
+  std::vector<pod_vector<uint64_t>> multiples_;
+  maxuint_t low_ = 0;
+  int threads_;
+};
+
+/// Count the primes inside [low, high] using
+/// multiple threads.
+///
+maxuint_t count_primes_sieve(maxuint_t low, maxuint_t high, int threads);
+
+} // namespace
+
+#endif
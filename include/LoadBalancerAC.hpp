@@ -17,20 +17,26 @@
 #define LOADBALANCERAC_HPP
 
 #include "OmpLock.hpp"
+#include "print.hpp"
 #include <stdint.h>
 
 namespace primecount {
 
+class CancellationToken;
+
 class LoadBalancerAC
 {
 public:
-  LoadBalancerAC(int64_t sqrtx, int64_t y, int threads, bool is_print);
+  LoadBalancerAC(const char* formula, int64_t sqrtx, int64_t y, int threads, bool is_print);
   bool get_work(int64_t& low, int64_t& high);
 
 private:
   void validate_segment_sizes();
   void compute_total_segments();
   void print_status();
+  bool next_work(int64_t& low, int64_t& high);
+  bool update_progress(Progress& progress);
+  bool is_cancelled() const;
 
   int64_t low_ = 0;
   int64_t sqrtx_ = 0;
@@ -41,8 +47,13 @@ private:
   int64_t segment_nr_ = 0;
   int64_t total_segments_ = 0;
   double time_ = 0;
+  double start_time_ = 0;
+  double progress_time_ = 0;
+  ProgressReporter progress_;
+  const char* formula_ = nullptr;
   int threads_ = 0;
   bool is_print_ = false;
+  const CancellationToken* token_ = nullptr;
   OmpLock lock_;
 };
 
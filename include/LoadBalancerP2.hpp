@@ -15,29 +15,40 @@
 
 #include "int128_t.hpp"
 #include "OmpLock.hpp"
+#include "print.hpp"
 
 #include <stdint.h>
 
 namespace primecount {
 
+class CancellationToken;
+
 class LoadBalancerP2
 {
 public:
-  LoadBalancerP2(maxint_t x, int64_t sieve_limit, int threads, bool is_print);
+  LoadBalancerP2(const char* formula, maxint_t x, int64_t sieve_limit, int threads, bool is_print);
   bool get_work(int64_t& low, int64_t& high);
   int get_threads() const;
 
 private:
   void print_status();
+  bool next_work(int64_t& low, int64_t& high);
+  bool update_progress(Progress& progress);
+  bool is_cancelled() const;
 
   int64_t low_ = 0;
   int64_t sieve_limit_ = 0;
   int64_t min_thread_dist_ = 0;
   int64_t thread_dist_ = 0;
   double time_ = 0;
+  double start_time_ = 0;
+  double progress_time_ = 0;
+  ProgressReporter progress_;
+  const char* formula_ = nullptr;
   int threads_ = 0;
   int precision_ = 0;
   bool is_print_ = false;
+  const CancellationToken* token_ = nullptr;
   OmpLock lock_;
 };
 
@@ -11,12 +11,16 @@
 #define LOADBALANCERS2_HPP
 
 #include "primecount-internal.hpp"
+#include "generate_phi.hpp"
 #include "int128_t.hpp"
 #include "macros.hpp"
 #include "OmpLock.hpp"
+#include "pod_vector.hpp"
+#include "print.hpp"
 #include "StatusS2.hpp"
 
 #include <stdint.h>
+#include <atomic>
 
 namespace primecount {
 
@@ -25,10 +29,56 @@ struct ThreadData
   int64_t low = 0;
   int64_t segments = 0;
   int64_t segment_size = 0;
+  /// Sum of the thread's intervals that has not
+  /// yet been added to the LoadBalancerS2's sum.
   maxint_t sum = 0;
   double init_secs = 0;
   double secs = 0;
 
+  /// phi[b] values at the end of the previous interval
+  /// [..., phi_low[ of this thread. These are reused if the
+  /// next interval starts at phi_low (see update_phi()).
+  /// phi[b] is valid for phi_min_b <= b < phi_max_b.
+  pod_vector<int64_t> phi;
+  int64_t phi_low = -1;
+  int64_t phi_min_b = 0;
+  int64_t phi_max_b = 0;
+
+  /// Returns phi[b] = phi(low - 1, b - 1) for 1 <= b <= max_b.
+  /// If the previous interval of this thread ended at low we
+  /// reuse its phi[b] values and only compute the missing
+  /// ones, see update_phi() in generate_phi.hpp.
+  ///
+  template <typename Primes>
+  pod_vector<int64_t> get_phi(int64_t low,
+                              int64_t max_b,
+                              const Primes& primes,
+                              const PiTable& pi)
+  {
+    if (phi_low != low)
+      phi_max_b = 0;
+
+    pod_vector<int64_t> phi_b;
+    phi_b.swap(phi);
+    update_phi(low, max_b, primes, pi, phi_b, phi_min_b, phi_max_b);
+    return phi_b;
+  }
+
+  /// Keep the phi[b] values at the end of the thread's
+  /// interval [..., limit[ for the next interval,
+  /// phi[b] is valid for min_b <= b < max_b.
+  ///
+  void save_phi(pod_vector<int64_t>& phi_b,
+                int64_t limit,
+                int64_t min_b,
+                int64_t max_b)
+  {
+    phi.swap(phi_b);
+    phi_low = limit;
+    phi_min_b = min_b;
+    phi_max_b = max_b;
+  }
+
   void start_time()
   {
     secs = get_time();
@@ -54,26 +104,35 @@ struct ThreadData
 class LoadBalancerS2
 {
 public:
-  LoadBalancerS2(maxint_t x, int64_t sieve_limit, maxint_t sum_approx, int threads, bool is_print);
+  LoadBalancerS2(const char* formula, maxint_t x, int64_t sieve_limit, maxint_t sum_approx, int threads, bool is_print);
   bool get_work(ThreadData& thread);
   maxint_t get_sum() const;
 
 private:
+  bool update(ThreadData& thread, Progress& progress);
   void update_load_balancing(const ThreadData& thread);
   void update_number_of_segments(const ThreadData& thread);
   void update_segment_size();
   double remaining_secs() const;
+  bool is_cancelled() const;
 
-  int64_t low_ = 0;
+  // Use padding to avoid CPU false sharing
+  MAYBE_UNUSED char pad1[MAX_CACHE_LINE_SIZE];
+  std::atomic<int64_t> low_{0};
+  std::atomic<int64_t> segments_{0};
+  std::atomic<int64_t> segment_size_{0};
+  MAYBE_UNUSED char pad2[MAX_CACHE_LINE_SIZE];
   int64_t max_low_ = 0;
   int64_t sieve_limit_ = 0;
-  int64_t segments_ = 0;
-  int64_t segment_size_ = 0;
   int64_t max_size_ = 0;
   maxint_t sum_ = 0;
   maxint_t sum_approx_ = 0;
   double time_ = 0;
+  double progress_time_ = 0;
+  ProgressReporter progress_;
+  const char* formula_ = nullptr;
   bool is_print_ = false;
+  const CancellationToken* token_ = nullptr;
   StatusS2 status_;
   OmpLock lock_;
 };
@@ -1,7 +1,7 @@
 ///
 /// @file   OmpLock.hpp
-/// @brief  The OmpLock and LockGuard classes are RAII-style
-///         wrappers for OpenMP locks.
+/// @brief  The OmpLock, LockGuard and TryLockGuard classes are
+///         RAII-style wrappers for OpenMP locks.
 ///
 /// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
 ///
@@ -19,16 +19,21 @@
   #include <omp.h>
 #else
 
-// If OpenMP is disabled we define the functions used by
-// the OmpLock and LockGuard classes as no-op.
+#include <mutex>
+
+// If OpenMP is disabled primecount uses std::thread
+// (see parallel.hpp), hence we implement the functions
+// used by the OmpLock, LockGuard and TryLockGuard
+// classes using std::mutex.
 namespace {
 
-using omp_lock_t = int;
+using omp_lock_t = std::mutex;
 
 inline void omp_init_lock(omp_lock_t*) { }
 inline void omp_destroy_lock(omp_lock_t*) { }
-inline void omp_set_lock(omp_lock_t*) { }
-inline void omp_unset_lock(omp_lock_t*) { }
+inline void omp_set_lock(omp_lock_t* lock) { lock->lock(); }
+inline void omp_unset_lock(omp_lock_t* lock) { lock->unlock(); }
+inline int omp_test_lock(omp_lock_t* lock) { return lock->try_lock(); }
 
 } // namespace
 
@@ -93,6 +98,42 @@ private:
   omp_lock_t* lock_ = nullptr;
 };
 
+/// Like LockGuard but does not block if the lock is
+/// currently held by another thread, in this case
+/// owns_lock() returns false.
+///
+class TryLockGuard
+{
+public:
+  TryLockGuard(OmpLock& lock)
+  {
+    ASSERT(lock.is_initialized());
+
+    if (lock.threads_ > 1)
+    {
+      if (omp_test_lock(&lock.lock_))
+        lock_ = &lock.lock_;
+    }
+    else
+      owns_lock_ = true;
+  }
+
+  ~TryLockGuard()
+  {
+    if (lock_)
+      omp_unset_lock(lock_);
+  }
+
+  bool owns_lock() const
+  {
+    return owns_lock_ || lock_;
+  }
+
+private:
+  omp_lock_t* lock_ = nullptr;
+  bool owns_lock_ = false;
+};
+
 } // namespace
 
 #endif
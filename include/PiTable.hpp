@@ -21,6 +21,7 @@
 #include "popcnt.hpp"
 #include "macros.hpp"
 #include "pod_vector.hpp"
+#include "TableCache.hpp"
 
 #include <stdint.h>
 
@@ -49,8 +50,8 @@ public:
     if_unlikely(x < pi_tiny_.size())
       return pi_tiny_[x];
 
-    uint64_t count = pi_[x / 240].count;
-    uint64_t bits = pi_[x / 240].bits;
+    uint64_t count = table_[x / 240].count;
+    uint64_t bits = table_[x / 240].bits;
     uint64_t bitmask = unset_larger_[x % 240];
     return count + popcnt64(bits & bitmask);
   }
@@ -80,6 +81,8 @@ private:
   static const pod_array<pi_t, 64> pi_cache_;
   pod_vector<pi_t> pi_;
   pod_vector<uint64_t> counts_;
+  TableFile file_;
+  const pi_t* table_ = nullptr;
   uint64_t max_x_;
 };
 
@@ -0,0 +1,140 @@
+///
+/// @file  TableCache.hpp
+/// @brief Persistent on-disk cache for the PiTable, FactorTable
+///        and FactorTableD lookup tables. These lookup tables only
+///        depend on y (and z) but not on x, hence when computing
+///        pi(x) for many x of similar size (e.g. 10^23, 2*10^23,
+///        ...) the same lookup tables are generated over and over
+///        again. If a table cache directory has been set using
+///        Config::table_cache_dir or set_table_cache_dir(),
+///        generated lookup tables are saved to that directory and
+///        later computations map the existing table files into
+///        memory (mmap) instead of generating them. Memory mapped
+///        table files are also shared by all processes that use
+///        the same table cache directory. FactorTableD depends on
+///        y, its table file is only reused for the same y.
+///
+///        Table file format (host endianness):
+///        [TableHeader][table entries ...]
+///
+///        Since the lookup tables are indexed by number, a table
+///        file whose limit is larger than the requested limit can
+///        also be used, only its first pages will be accessed.
+///        There is at most one table file per table type, hence
+///        the size of the table cache directory is bounded.
+///        If a table cannot be saved we print a warning and
+///        continue without caching.
+///
+///        If the memory table cache is enabled (e.g. primecount
+///        1e20 2e20 3e20) the generated lookup tables are also
+///        kept in memory and reused by later computations of
+///        the same process, no table cache directory is needed.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef TABLECACHE_HPP
+#define TABLECACHE_HPP
+
+#include "pod_vector.hpp"
+
+#include <stdint.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace primecount {
+
+struct TableHeader
+{
+  TableHeader() = default;
+  TableHeader(uint32_t wheel_size,
+              uint32_t sizeof_entry,
+              uint64_t max_number,
+              uint64_t entries,
+              uint64_t max_prime = 0) :
+    wheel(wheel_size),
+    entry_size(sizeof_entry),
+    limit(max_number),
+    y(max_prime),
+    size(entries)
+  { }
+
+  char magic[8] = { 'P', 'C', 'T', 'A', 'B', 'L', 'E', '\0' };
+  uint32_t version = 1;
+  /// Numbers per wheel cycle, 240 for the PiTable
+  /// and 2310 for FactorTable & FactorTableD.
+  uint32_t wheel = 0;
+  /// sizeof() of a table entry
+  uint32_t entry_size = 0;
+  uint32_t reserved = 0;
+  /// Table contains entries for numbers <= limit
+  uint64_t limit = 0;
+  /// FactorTableD only: numbers with a prime factor > y
+  /// have been removed from the table.
+  uint64_t y = 0;
+  /// Number of table entries
+  uint64_t size = 0;
+};
+
+bool is_table_cache(uint64_t limit);
+bool is_memory_table_cache();
+void set_memory_table_cache(bool enable);
+std::string get_table_cache_dir();
+void save_table(const std::string& name, const TableHeader& header, const void* table);
+void save_memory_table(const std::string& name, const TableHeader& header, const std::shared_ptr<const void>& table);
+
+/// Read-only table file that is mapped into memory
+/// (or a table of the memory table cache)
+class TableFile
+{
+public:
+  TableFile() = default;
+  ~TableFile();
+  TableFile(const TableFile&) = delete;
+  TableFile& operator=(const TableFile&) = delete;
+
+  /// Map the table file named name into memory. Returns
+  /// nullptr if the file does not exist or if its header
+  /// does not match the requested table (its limit must be
+  /// >= header.limit). Otherwise returns a pointer to the
+  /// first table entry.
+  ///
+  const void* open(const std::string& name, const TableHeader& header);
+
+  /// Save the generated table to the table cache directory.
+  /// If the memory table cache is enabled the table is moved
+  /// into the memory table cache. Returns a pointer to the
+  /// first table entry.
+  ///
+  template <typename T>
+  const T* save(const std::string& name,
+                const TableHeader& header,
+                pod_vector<T>& table)
+  {
+    if (!get_table_cache_dir().empty())
+      save_table(name, header, table.data());
+
+    if (!is_memory_table_cache())
+      return table.data();
+
+    auto vect = std::make_shared<pod_vector<T>>(std::move(table));
+    memory_ = std::shared_ptr<const void>(vect, vect->data());
+    save_memory_table(name, header, memory_);
+    return vect->data();
+  }
+
+private:
+  void* map_ = nullptr;
+  std::size_t size_ = 0;
+  pod_vector<uint64_t> buffer_;
+  std::shared_ptr<const void> memory_;
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,85 @@
+///
+/// @file  TaskScheduler.hpp
+/// @brief The TaskScheduler assigns work to the threads in loops
+///        of the form: for (b...) for (i = start; i < stop; i++)
+///        where the cost of the outer loop iterations shrinks
+///        steeply as b (and hence primes[b]) grows. Handing out
+///        work one b at a time leaves stragglers on the first,
+///        most expensive b values. Hence the TaskScheduler splits
+///        the expensive b values into multiple tasks that each
+///        process a sub-range [start, stop[ of the inner loop.
+///        It is used by the Phi0, C1 and S2_easy formulas.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef TASKSCHEDULER_HPP
+#define TASKSCHEDULER_HPP
+
+#include "primecount.hpp"
+#include "primecount-config.hpp"
+#include "primecount-internal.hpp"
+#include "macros.hpp"
+#include "pod_vector.hpp"
+
+#include <stdint.h>
+#include <atomic>
+
+namespace primecount {
+
+/// Process the inner loop iterations
+/// start <= i < stop of the outer loop iteration b.
+///
+struct Task
+{
+  int64_t b;
+  int64_t start;
+  int64_t stop;
+};
+
+class TaskScheduler
+{
+public:
+  /// Add the outer loop iteration b whose inner loop iterates
+  /// over start <= i < stop. cost is an estimate of the
+  /// runtime of the entire outer loop iteration.
+  ///
+  void add(int64_t b, int64_t start, int64_t stop, double cost);
+
+  /// Split the expensive outer loop iterations into
+  /// multiple tasks. Must be called after all outer loop
+  /// iterations have been added and before get_task().
+  ///
+  void split(int threads);
+
+  /// Get the next task, tasks are handed out in the order
+  /// in which their outer loop iterations have been added.
+  /// Returns false if there are no more tasks or if the
+  /// pi_async() computation has been cancelled.
+  ///
+  bool get_task(Task& task)
+  {
+    std::size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+    if (i >= tasks_.size() ||
+        (token_ && token_->is_cancelled()))
+      return false;
+    task = tasks_[i];
+    return true;
+  }
+
+private:
+  pod_vector<Task> tasks_;
+  pod_vector<double> costs_;
+  const CancellationToken* token_ = get_cancellation_token();
+  // Use padding to avoid CPU false sharing
+  MAYBE_UNUSED char pad1[MAX_CACHE_LINE_SIZE];
+  std::atomic<std::size_t> next_{0};
+  MAYBE_UNUSED char pad2[MAX_CACHE_LINE_SIZE];
+};
+
+} // namespace
+
+#endif
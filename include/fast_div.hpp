@@ -26,6 +26,7 @@
 #ifndef FAST_DIV_HPP
 #define FAST_DIV_HPP
 
+#include "Divider128.hpp"
 #include "macros.hpp"
 
 #include <limits>
@@ -180,6 +181,21 @@ fast_div64(X x, Y y)
 #endif
 }
 
+#if defined(HAVE_INT128_T)
+
+/// Used for (128-bit / 64-bit) = 64-bit using
+/// the precomputed reciprocal of the divisor.
+/// Use this function only when you know for sure
+/// that the result is < 2^64.
+///
+template <typename X>
+ALWAYS_INLINE uint64_t fast_div64(X x, const primecount::Divider128& y)
+{
+  return y.divide(x);
+}
+
+#endif
+
 /// Used for (64-bit / 32-bit) = 64-bit.
 /// Used for (64-bit / 64-bit) = 64-bit.
 template <typename X, typename Y>
@@ -0,0 +1,85 @@
+///
+/// @file  parallel.hpp
+/// @brief Parallel regions and reductions. By default these are
+///        implemented using OpenMP. If primecount is compiled
+///        without OpenMP (e.g. cmake -DWITH_OPENMP=OFF) the
+///        threads are created using std::thread instead, this
+///        way primecount is multi-threaded even without OpenMP.
+///        The std::thread threads are kept in a persistent
+///        thread pool (ThreadPool.cpp) that is reused by all
+///        parallel regions.
+///        Locks (OmpLock.hpp) and atomics (RelaxedAtomic.hpp)
+///        work with both backends.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <functional>
+#include <vector>
+
+namespace primecount {
+
+#if !defined(_OPENMP)
+
+/// Run func(thread_num) for 0 <= thread_num < threads using
+/// the threads of the persistent thread pool. If the thread
+/// pool is busy new threads are used. Nested parallel regions
+/// are executed serially by the calling thread. If func throws
+/// an exception, it is rethrown after all threads have finished.
+///
+void thread_pool_run(int threads, const std::function<void(int)>& func);
+
+#endif
+
+/// Run func(thread_num) for 0 <= thread_num < threads,
+/// each in its own thread, and wait until all
+/// threads have finished.
+///
+template <typename F>
+void parallel_region(int threads, F&& func)
+{
+  if (threads <= 1)
+  {
+    func(0);
+    return;
+  }
+
+#if defined(_OPENMP)
+  // If OpenMP creates fewer threads than requested,
+  // some threads execute multiple thread_nums.
+  #pragma omp parallel for schedule(static, 1) num_threads(threads)
+  for (int t = 0; t < threads; t++)
+    func(t);
+#else
+  thread_pool_run(threads, std::ref(func));
+#endif
+}
+
+/// Same as parallel_region() but returns the
+/// sum of the values returned by func(thread_num).
+///
+template <typename T, typename F>
+T parallel_sum(int threads, F&& func)
+{
+  std::vector<T> sums(threads > 1 ? threads : 1);
+
+  parallel_region(threads, [&](int thread_num) {
+    sums[thread_num] = func(thread_num);
+  });
+
+  T sum = 0;
+  for (const T& n : sums)
+    sum += n;
+
+  return sum;
+}
+
+} // namespace
+
+#endif
@@ -17,15 +17,84 @@
 
 #include <stdint.h>
 #include <algorithm>
+#include <functional>
 #include <string>
 #include <utility>
 
 namespace primecount {
 
+struct Config;
+class CancellationToken;
+
 template<class T>
 void unused_param(const T&)
 { }
 
+/// Makes the settings of config the current settings of
+/// the calling thread (e.g. get_alpha_gourdon() uses
+/// config.alpha_y) until the ConfigGuard is destroyed.
+///
+class ConfigGuard
+{
+public:
+  ConfigGuard(const Config& config);
+  ~ConfigGuard();
+  ConfigGuard(const ConfigGuard&) = delete;
+  ConfigGuard& operator=(const ConfigGuard&) = delete;
+private:
+  const Config* prev_;
+};
+
+/// Returns the Config of the current pi(x, config)
+/// computation of the calling thread or nullptr.
+///
+const Config* get_config();
+
+/// Number of threads of a pi(x, config) computation,
+/// 1 <= config.threads <= max threads.
+///
+int config_threads(const Config& config);
+
+/// Makes token the cancellation token of the calling thread
+/// until the CancellationGuard is destroyed. The load balancers
+/// get the token when they are constructed and stop handing
+/// out work once the token has been cancelled.
+///
+class CancellationGuard
+{
+public:
+  CancellationGuard(const CancellationToken& token);
+  ~CancellationGuard();
+  CancellationGuard(const CancellationGuard&) = delete;
+  CancellationGuard& operator=(const CancellationGuard&) = delete;
+private:
+  const CancellationToken* prev_;
+};
+
+/// Returns nullptr if the computation cannot be cancelled
+const CancellationToken* get_cancellation_token();
+
+/// Throws a primecount_error if the cancellation
+/// token of the calling thread has been cancelled.
+///
+void check_cancelled();
+
+/// Variables of the Deleglise-Rivat algorithm
+struct DelegliseRivatVars
+{
+  int64_t y;
+  int64_t z;
+  int64_t c;
+};
+
+/// Variables of Xavier Gourdon's algorithm
+struct GourdonVars
+{
+  int64_t y;
+  int64_t z;
+  int64_t k;
+};
+
 int64_t pi_lmo1(int64_t x);
 int64_t pi_lmo2(int64_t x);
 int64_t pi_lmo3(int64_t x);
@@ -33,10 +102,14 @@ int64_t pi_lmo4(int64_t x);
 int64_t pi_primesieve(int64_t x);
 
 std::string pi(const std::string& x, int threads);
+std::string pi(const std::string& x, const std::string& y, int threads);
+maxint_t count_primes(maxint_t a, maxint_t b, int threads);
+void pi_grid(maxint_t x0, maxint_t step, int64_t count, int threads, const std::function<void(maxint_t, maxint_t)>& callback);
 int64_t pi(int64_t x, int threads);
 int64_t pi_noprint(int64_t x, int threads);
 int64_t pi_deleglise_rivat(int64_t x, int threads);
 int64_t nth_prime(int64_t n, int threads);
+std::string nth_prime(const std::string& n, int threads);
 
 int64_t pi_cache(int64_t x, bool print = is_print());
 int64_t pi_deleglise_rivat_64(int64_t x, int threads, bool print = is_print());
@@ -58,6 +131,7 @@ int64_t Ri_inverse(int64_t);
   int128_t pi(int128_t x);
   int128_t pi(int128_t x, int threads);
   int128_t pi_deleglise_rivat(int128_t x, int threads);
+  int128_t nth_prime(int128_t n, int threads);
   int128_t pi_deleglise_rivat_128(int128_t x, int threads, bool print = is_print());
   int128_t P2(int128_t x, int64_t y, int64_t a, int threads, bool print = is_print());
 
@@ -72,6 +146,7 @@ int get_status_precision(maxint_t x);
 void set_alpha(double alpha);
 void set_alpha_y(double alpha_y);
 void set_alpha_z(double alpha_z);
+void set_table_cache_dir(const std::string& dir);
 double get_alpha(maxint_t x, int64_t y);
 double get_alpha_y(maxint_t x, int64_t y);
 double get_alpha_z(int64_t y, int64_t z);
@@ -79,6 +154,8 @@ double get_alpha_lmo(maxint_t x);
 double get_alpha_deleglise_rivat(maxint_t x);
 std::pair<double, double> get_alpha_gourdon(maxint_t x);
 int64_t get_x_star_gourdon(maxint_t x, int64_t y);
+DelegliseRivatVars get_deleglise_rivat_vars(maxint_t x);
+GourdonVars get_gourdon_vars(maxint_t x);
 maxint_t get_max_x(double alpha_y);
 maxint_t to_maxint(const std::string& expr);
 double get_time();
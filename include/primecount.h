@@ -54,6 +54,48 @@ int64_t primecount_pi(int64_t x);
  */
 int primecount_pi_str(const char* x, char* res, size_t len);
 
+/*
+ * Cancellation token for primecount_pi_async().
+ * Create it using primecount_token_create() and free it
+ * using primecount_token_destroy(). The token may be
+ * destroyed before the computation has finished.
+ */
+typedef struct primecount_token primecount_token;
+
+primecount_token* primecount_token_create();
+void primecount_token_cancel(primecount_token* token);
+void primecount_token_destroy(primecount_token* token);
+
+/*
+ * Called by primecount_pi_async() once the computation has
+ * finished. res is the result as a null-terminated string
+ * or NULL if an error occurred or if the computation has
+ * been cancelled. data is the user data pointer that has
+ * been passed to primecount_pi_async().
+ */
+typedef void (*primecount_callback)(const char* res, void* data);
+
+/*
+ * Count the number of primes <= x in a background thread,
+ * see primecount_pi_str(). Once the computation has finished
+ * callback(res, data) is called from the background thread.
+ * The computation can be stopped using
+ * primecount_token_cancel(token), token may be NULL.
+ * Returns -1 if an error occurs, else 0.
+ */
+int primecount_pi_async(const char* x, primecount_token* token, primecount_callback callback, void* data);
+
+/*
+ * Count the number of primes inside [a, b]. If b - a is small
+ * the primes are counted using a segmented sieve of
+ * Eratosthenes, else pi(b) - pi(a - 1) is computed using the
+ * prime counting function. Uses all CPU cores by default.
+ * Returns -1 if an error occurs.
+ *
+ * Run time: min(O(b - a + sqrt(b)), O(b^(2/3) / (log b)^2))
+ */
+int64_t primecount_count_primes(int64_t a, int64_t b);
+
 /*
  * Partial sieve function (a.k.a. Legendre-sum).
  * phi(x, a) counts the numbers <= x that are not divisible
@@ -73,6 +115,26 @@ int64_t primecount_phi(int64_t x, int64_t a);
  */
 int64_t primecount_nth_prime(int64_t n);
 
+/*
+ * 128-bit nth prime function.
+ * Find the nth prime using a combination of the prime counting
+ * function and the sieve of Eratosthenes.
+ *
+ * @param n    Null-terminated string integer e.g. "12345".
+ *             Note that n must be <= 10^29 on 64-bit systems
+ *             and <= 216289611853439384 on 32-bit systems.
+ * @param res  Result output buffer.
+ * @param len  Length of the res buffer. The length must be sufficiently
+ *             large to fit the result, 32 is always enough.
+ * @return     Returns -1 if an error occurs, else returns the number
+ *             of characters (>= 1) that have been written to the
+ *             res buffer, not counting the terminating null character.
+ *
+ * Run time: O(x^(2/3) / (log x)^2)
+ * Memory usage: O(x^(1/2))
+ */
+int primecount_nth_prime_str(const char* n, char* res, size_t len);
+
 /*
  * Largest number supported by primecount_pi_str(x).
  * @return 64-bit CPUs: 10^31,
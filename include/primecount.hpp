@@ -13,6 +13,10 @@
 #ifndef PRIMECOUNT_HPP
 #define PRIMECOUNT_HPP
 
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <stdint.h>
@@ -31,6 +35,31 @@ public:
   { }
 };
 
+/// Settings of a primecount computation. Unlike the global
+/// settings e.g. set_num_threads(), a Config only applies to
+/// the computations it is passed to. Hence multiple computations
+/// with different settings can safely run concurrently in the
+/// same process. Unset settings use the global settings.
+///
+struct Config
+{
+  /// Number of threads, if < 1 get_num_threads() is used
+  int threads = 0;
+  /// Tuning factor of the Deleglise-Rivat and LMO algorithms,
+  /// y = x^(1/3) * alpha. If < 1 alpha is computed at runtime.
+  double alpha = 0;
+  /// Tuning factors of Xavier Gourdon's algorithm,
+  /// y = x^(1/3) * alpha_y, z = y * alpha_z.
+  /// If < 1 these are computed at runtime.
+  double alpha_y = 0;
+  double alpha_z = 0;
+  /// Directory in which the generated lookup tables are
+  /// saved and from which they are reused by later
+  /// computations. If empty the default table cache
+  /// directory is used (none by default).
+  std::string table_cache_dir;
+};
+
 /// Count the number of primes <= x using Xavier Gourdon's
 /// algorithm. Uses all CPU cores by default.
 /// Throws a primecount_error if an error occurs.
@@ -40,6 +69,9 @@ public:
 ///
 int64_t pi(int64_t x);
 
+/// Same as pi(x) but uses the settings from config
+int64_t pi(int64_t x, const Config& config);
+
 /// 128-bit prime counting function.
 /// Count the number of primes <= x using Xavier Gourdon's
 /// algorithm. Uses all CPU cores by default.
@@ -54,6 +86,50 @@ int64_t pi(int64_t x);
 ///
 std::string pi(const std::string& x);
 
+/// Same as pi(x) but uses the settings from config
+std::string pi(const std::string& x, const Config& config);
+
+/// Count the number of primes inside ]x, y] i.e. pi(y) - pi(x).
+/// Same as count_primes(x + 1, y), see below.
+///
+/// @param x, y Null-terminated string integers e.g. "12345".
+///             Note that y must be <= get_max_x().
+///
+std::string pi(const std::string& x, const std::string& y);
+
+/// Count the number of primes inside [a, b]. If b - a is small
+/// the primes are counted using a segmented sieve of
+/// Eratosthenes, else pi(b) - pi(a - 1) is computed using the
+/// prime counting function. Uses all CPU cores by default.
+/// Throws a primecount_error if an error occurs.
+///
+/// Run time: min(O(b - a + sqrt(b)), O(b^(2/3) / (log b)^2))
+///
+int64_t count_primes(int64_t a, int64_t b);
+
+/// Same as count_primes(a, b) but supports 128-bit a and b.
+/// @param a, b Null-terminated string integers e.g. "12345".
+///             Note that b must be <= get_max_x().
+///
+std::string count_primes(const std::string& a, const std::string& b);
+
+/// Tabulate the prime counting function on an arithmetic grid.
+/// Calls callback(x, pi(x)) for x = x0 + i * step with
+/// 0 <= i < count in increasing order of x. pi(x0) is computed
+/// using the prime counting function, the remaining grid points
+/// are computed using a parallel segmented sieve of
+/// Eratosthenes (or using the prime counting function if the
+/// step is large). Uses all CPU cores by default.
+/// Throws a primecount_error if an error occurs.
+///
+void pi_grid(int64_t x0, int64_t step, int64_t count, const std::function<void(int64_t x, int64_t pix)>& callback);
+
+/// Same as pi_grid(x0, step, count, callback) but supports 128-bit
+/// grid points. Note that x0 + (count - 1) * step must be <= get_max_x().
+///
+void pi_grid(const std::string& x0, const std::string& step, int64_t count,
+             const std::function<void(const std::string& x, const std::string& pix)>& callback);
+
 /// Partial sieve function (a.k.a. Legendre-sum).
 /// phi(x, a) counts the numbers <= x that are not divisible
 /// by any of the first a primes.
@@ -61,6 +137,9 @@ std::string pi(const std::string& x);
 ///
 int64_t phi(int64_t x, int64_t a);
 
+/// Same as phi(x, a) but uses the settings from config
+int64_t phi(int64_t x, int64_t a, const Config& config);
+
 /// Find the nth prime using a combination of the prime counting
 /// function and the sieve of Eratosthenes.
 /// @pre n <= 216289611853439384
@@ -71,6 +150,89 @@ int64_t phi(int64_t x, int64_t a);
 ///
 int64_t nth_prime(int64_t n);
 
+/// Same as nth_prime(n) but uses the settings from config
+int64_t nth_prime(int64_t n, const Config& config);
+
+/// 128-bit nth prime function.
+/// Find the nth prime using a combination of the prime counting
+/// function and the sieve of Eratosthenes.
+///
+/// @param n Null-terminated string integer e.g. "12345".
+///          Note that n must be <= 10^29 on 64-bit systems
+///          and <= 216289611853439384 on 32-bit systems.
+/// Throws a primecount_error if an error occurs.
+///
+/// Run time: O(x^(2/3) / (log x)^2)
+/// Memory usage: O(x^(1/2))
+///
+std::string nth_prime(const std::string& n);
+
+/// Same as nth_prime(n) but uses the settings from config
+std::string nth_prime(const std::string& n, const Config& config);
+
+/// Used to cancel computations started using pi_async().
+/// Copies of a CancellationToken share the same state,
+/// cancel() cancels all computations that use a copy
+/// of the token.
+///
+class CancellationToken
+{
+public:
+  CancellationToken()
+    : cancelled_(std::make_shared<std::atomic<bool>>(false))
+  { }
+
+  void cancel()
+  {
+    cancelled_->store(true, std::memory_order_relaxed);
+  }
+
+  bool is_cancelled() const
+  {
+    return cancelled_->load(std::memory_order_relaxed);
+  }
+
+private:
+  std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+/// Count the number of primes <= x in a background thread.
+/// The computation can be stopped using token.cancel(), the
+/// threads then stop after finishing their current chunk of
+/// work and the future throws a primecount_error.
+///
+std::future<int64_t> pi_async(int64_t x, const CancellationToken& token = CancellationToken());
+
+/// 128-bit version of pi_async(), see pi(const std::string& x)
+std::future<std::string> pi_async(const std::string& x, const CancellationToken& token = CancellationToken());
+
+/// Progress of a long running formula of pi(x),
+/// see set_progress_callback().
+///
+struct Progress
+{
+  /// Formula name e.g. "S2_hard", "D", "B" or "AC"
+  std::string formula;
+  /// Percentage of the formula that has been computed
+  double percent = 0;
+  /// Estimated remaining seconds of the formula
+  double remaining_secs = 0;
+  /// Current partial sum of the formula,
+  /// empty string if not available.
+  std::string sum;
+};
+
+/// Register a callback that receives the progress of the long
+/// running formulas at most every interval seconds. The callback
+/// is invoked from primecount's worker threads, but never
+/// concurrently and never while holding a load balancer lock.
+/// It must return quickly and must not throw. Pass nullptr to
+/// remove the callback. This function is thread-safe, each
+/// formula uses the callback that was registered when the
+/// formula started.
+///
+void set_progress_callback(std::function<void(const Progress&)> callback, double interval = 1.0);
+
 /// Largest number supported by pi(const std::string& x).
 /// @return 64-bit CPUs: 10^31,
 ///         32-bit CPUs: 2^63-1.
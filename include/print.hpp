@@ -12,6 +12,8 @@
 
 #include "int128_t.hpp"
 #include <stdint.h>
+#include <functional>
+#include <memory>
 
 #if !defined(__has_include)
   #define __has_include(x) 0
@@ -26,6 +28,8 @@
 
 namespace primecount {
 
+struct Progress;
+
 void set_print(bool print);
 void set_print_variables(bool print_variables);
 
@@ -40,6 +44,38 @@ void print_vars(maxint_t x, int64_t y, int threads);
 void print_vars(maxint_t x, int64_t y, int64_t c, int threads);
 void print_seconds(double seconds);
 
+/// Snapshot of the progress callback (see set_progress_callback())
+/// that is taken once per formula, when the formula's load
+/// balancer is constructed. The worker threads only use the
+/// snapshot, hence set_progress_callback() can be called
+/// concurrently e.g. while a pi_async() computation runs.
+///
+class ProgressReporter
+{
+public:
+  ProgressReporter();
+  explicit operator bool() const { return !!callback_; }
+
+  /// Returns true if at least interval seconds have
+  /// elapsed since time. The caller has to ensure that
+  /// only 1 thread at a time updates time.
+  ///
+  bool is_due(double& time) const;
+
+  /// Must be called without holding a load balancer lock.
+  /// If another thread is currently executing the callback
+  /// this progress report is skipped, the worker threads
+  /// never wait for the callback.
+  ///
+  void report(const Progress& progress) const;
+
+private:
+  std::shared_ptr<const std::function<void(const Progress&)>> callback_;
+  double interval_ = 1.0;
+};
+
+double get_remaining_secs(double start_time, double percent);
+
 void print_gourdon(maxint_t x, int64_t y, int64_t z, int64_t k, int threads);
 void print_gourdon_vars(maxint_t x, int64_t y, int threads);
 void print_gourdon_vars(maxint_t x, int64_t y, int64_t z, int64_t k,  int threads);
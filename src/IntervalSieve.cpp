@@ -0,0 +1,374 @@
+///
+/// @file  IntervalSieve.cpp
+/// @brief Segmented sieve of Eratosthenes for intervals [low, high]
+///        whose bounds may be 128-bit integers. Each segment is
+///        sieved using the primes <= sqrt(high) that are
+///        generated using primesieve. The segment is split into
+///        one sub-interval per thread and each thread crosses off
+///        the multiples of all sieving primes inside its own
+///        sub-interval.
+///
+///        Storing the sieving primes and their next multiples
+///        across segments (like primesieve) would require
+///        16 bytes per sieving prime i.e. about 3 GiB for
+///        numbers slightly above 2^64 and 60 GiB near 10^22,
+///        hence the sieving primes are regenerated for each
+///        segment instead. In order to bound the memory usage
+///        the sieving primes are generated in blocks: first
+///        all threads generate the primes of the current block
+///        in parallel (each thread a part of the block) and
+///        compute their first multiple inside the segment, then
+///        all threads cross off the multiples of the block's
+///        primes inside their own sub-interval. Sieving primes
+///        with at most 1 multiple per sub-interval are not
+///        stored, only their multiples are stored (like the
+///        buckets in primesieve).
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "IntervalSieve.hpp"
+#include "primecount.hpp"
+#include "primecount-internal.hpp"
+#include "primesieve.hpp"
+#include "parallel.hpp"
+#include "int128_t.hpp"
+#include "imath.hpp"
+#include "isqrt.hpp"
+#include "macros.hpp"
+#include "min.hpp"
+#include "popcnt.hpp"
+
+#include <stdint.h>
+#include <algorithm>
+
+namespace {
+
+/// The 8 bits of each byte of the sieve array correspond
+/// to the offsets { 1, 7, 11, 13, 17, 19, 23, 29 }.
+///
+const int offsets[8] = { 1, 7, 11, 13, 17, 19, 23, 29 };
+
+/// Count the primes inside [start, stop] using 1 thread.
+/// The primes are counted per buffer of primes (like in
+/// P2.cpp) instead of one by one.
+///
+uint64_t count_primes64(uint64_t start, uint64_t stop)
+{
+  // Largest prime < 2^64, primesieve::iterator
+  // cannot generate primes > 2^64.
+  stop = std::min(stop, (uint64_t) 18446744073709551557ull);
+  if (start > stop)
+    return 0;
+
+  primesieve::iterator it(start, stop);
+  it.generate_next_primes();
+  uint64_t count = 0;
+
+  for (; it.primes_[it.size_ - 1] < stop; it.generate_next_primes())
+    count += it.size_ - it.i_;
+  for (; it.i_ < it.size_ && it.primes_[it.i_] <= stop; it.i_++)
+    count += 1;
+
+  return count;
+}
+
+} // namespace
+
+namespace primecount {
+
+IntervalSieve::IntervalSieve(int threads) :
+  threads_(std::max(threads, 1))
+{ }
+
+void IntervalSieve::sieve(maxuint_t low, maxuint_t high)
+{
+  ASSERT(low <= high);
+  ASSERT(high - low < segment_size());
+
+  low_ = low - low % 240;
+  uint64_t dist = (uint64_t) (high - low_);
+  uint64_t size = dist / 240 + 1;
+  sieve_.resize(size);
+  std::fill(sieve_.begin(), sieve_.end(), ~0ull);
+
+  // Unset bits < low and > high
+  uint64_t low_offset = (uint64_t) (low - low_);
+  if (low_offset > 0)
+    sieve_[0] &= ~unset_larger_[low_offset - 1];
+  sieve_[size - 1] &= unset_larger_[dist % 240];
+
+  uint64_t sqrt_high = (uint64_t) isqrt(high);
+  ASSERT(low_ > sqrt_high);
+
+  int64_t thread_threshold = (int64_t) 1e7;
+  int64_t thread_dist = (int64_t) std::max(dist, sqrt_high);
+  int threads = ideal_num_threads(thread_dist, threads_, thread_threshold);
+  uint64_t thread_words = ceil_div(size, threads);
+  uint64_t thread_size = thread_words * 240;
+  primes_.resize(threads);
+  multiples_.resize(threads * threads);
+
+  // The blocks grow with the sieving primes so that the
+  // number of stored multiples per block remains small.
+  uint64_t min_block = (1ull << 24) * threads;
+
+  for (uint64_t start = 7; start <= sqrt_high;)
+  {
+    uint64_t block = std::max(start / 16, min_block);
+    uint64_t stop = std::min(sqrt_high, start + (block - 1));
+    uint64_t block_dist = (stop - start) / threads + 1;
+
+    parallel_region(threads, [&](int t)
+    {
+      uint64_t begin = start + block_dist * t;
+      uint64_t end = std::min(begin + (block_dist - 1), stop);
+      generate_primes(t, threads, begin, end, thread_size);
+    });
+
+    parallel_region(threads, [&](int t)
+    {
+      cross_off(t, threads, thread_words);
+    });
+
+    start = stop + 1;
+  }
+}
+
+/// Generate the sieving primes inside [start, stop] and
+/// compute their first odd multiple >= low_. Primes that
+/// may have 2 or more multiples per sub-interval are stored
+/// in primes_[thread_num], for the other primes we store their
+/// multiples in multiples_[thread_num * threads + t] where
+/// t is the thread whose sub-interval contains the multiple.
+/// @pre start >= 7 and low_ > stop
+///
+void IntervalSieve::generate_primes(int thread_num,
+                                    int threads,
+                                    uint64_t start,
+                                    uint64_t stop,
+                                    uint64_t thread_size)
+{
+  auto& primes = primes_[thread_num];
+  auto* multiples = &multiples_[thread_num * threads];
+  primes.clear();
+
+  for (int t = 0; t < threads; t++)
+    multiples[t].clear();
+
+  if (start > stop)
+    return;
+
+  uint64_t limit = sieve_.size() * 240;
+  primesieve::iterator it(start, stop);
+  it.generate_next_primes();
+
+  // Iterate over the buffer of primes (like
+  // in P2.cpp) instead of one by one.
+  for (; it.primes_[it.i_] <= stop; it.generate_next_primes())
+  {
+    for (; it.i_ < it.size_; it.i_++)
+    {
+      uint64_t prime = it.primes_[it.i_];
+      if (prime > stop)
+        return;
+
+      // low_ + i is the first odd multiple of prime >= low_
+      uint64_t r = (uint64_t) (low_ % prime);
+      uint64_t i = (r == 0) ? 0 : prime - r;
+      if (i % 2 == 0)
+        i += prime;
+
+      if (prime * 2 < thread_size)
+        primes.push_back({prime, i});
+      else
+      {
+        for (; i < limit; i += prime * 2)
+          multiples[i / thread_size].push_back(i);
+      }
+    }
+  }
+}
+
+/// Cross off the multiples of the sieving primes of the
+/// current block inside the sub-interval of thread_num.
+///
+void IntervalSieve::cross_off(int thread_num,
+                              int threads,
+                              uint64_t thread_words)
+{
+  uint64_t begin = thread_words * thread_num;
+  uint64_t end = std::min(begin + thread_words, (uint64_t) sieve_.size());
+  if (begin >= end)
+    return;
+
+  uint64_t start = begin * 240;
+  uint64_t stop = end * 240;
+
+  for (int t = 0; t < threads; t++)
+  {
+    for (const SievingPrime& sp : primes_[t])
+    {
+      // First odd multiple >= start
+      uint64_t prime2 = sp.prime * 2;
+      uint64_t i = sp.multiple;
+      if (i < start)
+        i += ceil_div(start - i, prime2) * prime2;
+
+      for (; i < stop; i += prime2)
+        sieve_[i / 240] &= unset_bit_[i % 240];
+    }
+
+    for (uint64_t i : multiples_[t * threads + thread_num])
+      sieve_[i / 240] &= unset_bit_[i % 240];
+  }
+}
+
+uint64_t IntervalSieve::count() const
+{
+  uint64_t count = 0;
+
+  for (uint64_t bits : sieve_)
+    count += popcnt64(bits);
+
+  return count;
+}
+
+uint64_t IntervalSieve::count(maxuint_t low, maxuint_t high) const
+{
+  if (low > high)
+    return 0;
+
+  ASSERT(low >= low_);
+  ASSERT(high - low_ < sieve_.size() * 240);
+
+  uint64_t start = (uint64_t) (low - low_);
+  uint64_t stop = (uint64_t) (high - low_);
+  uint64_t i = start / 240;
+  uint64_t j = stop / 240;
+  uint64_t low_mask = (start % 240 == 0) ? ~0ull : ~unset_larger_[start % 240 - 1];
+  uint64_t high_mask = unset_larger_[stop % 240];
+
+  if (i == j)
+    return popcnt64(sieve_[i] & low_mask & high_mask);
+
+  uint64_t count = popcnt64(sieve_[i] & low_mask);
+  for (i++; i < j; i++)
+    count += popcnt64(sieve_[i]);
+  count += popcnt64(sieve_[j] & high_mask);
+
+  return count;
+}
+maxuint_t IntervalSieve::nth_prime(uint64_t n) const
+{
+  ASSERT(n >= 1);
+
+  for (uint64_t i = 0; i < sieve_.size(); i++)
+  {
+    uint64_t count = popcnt64(sieve_[i]);
+    if (count < n)
+      n -= count;
+    else
+    {
+      for (uint64_t bit = 0; bit < 64; bit++)
+        if ((sieve_[i] >> bit) & 1)
+          if (--n == 0)
+            return get_prime(i, bit);
+    }
+  }
+
+  throw primecount_error("IntervalSieve: nth_prime(n) out of range");
+}
+
+maxuint_t IntervalSieve::nth_prime_desc(uint64_t n) const
+{
+  ASSERT(n >= 1);
+
+  for (uint64_t i = sieve_.size(); i-- > 0;)
+  {
+    uint64_t count = popcnt64(sieve_[i]);
+    if (count < n)
+      n -= count;
+    else
+    {
+      for (uint64_t bit = 64; bit-- > 0;)
+        if ((sieve_[i] >> bit) & 1)
+          if (--n == 0)
+            return get_prime(i, bit);
+    }
+  }
+
+  throw primecount_error("IntervalSieve: nth_prime_desc(n) out of range");
+}
+
+/// Convert the bit of sieve_[i] to the corresponding integer
+maxuint_t IntervalSieve::get_prime(uint64_t i, uint64_t bit) const
+{
+  return low_ + i * 240 + (bit / 8) * 30 + offsets[bit % 8];
+}
+
+/// Count the primes inside [low, high] using multiple threads.
+/// The numbers < 2^64 are split into one chunk per thread
+/// whose primes are counted using primesieve::iterator. The
+/// larger numbers are sieved segment by segment using the
+/// IntervalSieve, each thread sieves a sub-interval of the
+/// current segment.
+///
+maxuint_t count_primes_sieve(maxuint_t low, maxuint_t high, int threads)
+{
+  maxuint_t count = 0;
+  low = max(low, 2);
+  if (low > high)
+    return count;
+
+  uint64_t max_stop = primesieve::get_max_stop();
+
+  if (low <= max_stop)
+  {
+    uint64_t start = (uint64_t) low;
+    uint64_t stop = (uint64_t) min(high, max_stop);
+    uint64_t dist = stop - start;
+    int64_t thread_threshold = (int64_t) max(isqrt(stop), (uint64_t) 1e7);
+    int64_t thread_dist = (int64_t) std::min(dist, (uint64_t) INT64_MAX);
+    int max_threads = ideal_num_threads(thread_dist, threads, thread_threshold);
+    uint64_t chunk = dist / max_threads + 1;
+
+    count += parallel_sum<maxuint_t>(max_threads, [&](int t)
+    {
+      uint64_t begin = start + chunk * t;
+      uint64_t end = begin + (chunk - 1);
+      if (t + 1 == max_threads)
+        end = stop;
+
+      return (maxuint_t) count_primes64(begin, end);
+    });
+
+    if (high <= max_stop)
+      return count;
+    low = (maxuint_t) max_stop + 1;
+  }
+
+  IntervalSieve sieve(threads);
+  uint64_t max_segment = sieve.segment_size();
+
+  while (true)
+  {
+    maxuint_t stop = high;
+    if (high - low >= max_segment)
+      stop = low + (max_segment - 1);
+
+    sieve.sieve(low, stop);
+    count += sieve.count();
+
+    if (stop >= high)
+      return count;
+
+    low = stop + 1;
+    check_cancelled();
+  }
+}
+
+} // namespace
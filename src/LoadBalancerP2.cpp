@@ -11,6 +11,8 @@
 ///
 
 #include "LoadBalancerP2.hpp"
+#include "primecount.hpp"
+#include "print.hpp"
 #include "primecount-internal.hpp"
 #include "imath.hpp"
 #include "min.hpp"
@@ -24,21 +26,32 @@
 namespace primecount {
 
 /// We need to sieve [sqrt(x), sieve_limit[
-LoadBalancerP2::LoadBalancerP2(maxint_t x,
+LoadBalancerP2::LoadBalancerP2(const char* formula,
+                               maxint_t x,
                                int64_t sieve_limit,
                                int threads,
                                bool is_print) :
   low_(isqrt(x)),
   sieve_limit_(sieve_limit),
+  start_time_(get_time()),
+  progress_time_(start_time_),
+  formula_(formula),
   precision_(get_status_precision(x)),
-  is_print_(is_print)
+  is_print_(is_print),
+  token_(get_cancellation_token())
 {
   low_ = min(low_, sieve_limit_);
   int64_t dist = sieve_limit_ - low_;
 
+  // The threads do not need to compute PrimePi(low),
+  // pi(low) is computed afterwards using a prefix sum
+  // over the prime counts of the previous chunks. Hence
+  // the thread initialization only generates the
+  // sieving primes <= sqrt(high).
+  min_thread_dist_ = max(isqrt(sieve_limit_), 1 << 23);
+
   // These load balancing settings work well on my
   // dual-socket AMD EPYC 7642 server with 192 CPU cores.
-  min_thread_dist_ = 1 << 23;
   int max_threads = (int) std::pow(sieve_limit_, 1 / 3.7);
   threads = std::min(threads, max_threads);
   threads_ = ideal_num_threads(dist, threads, min_thread_dist_);
@@ -59,9 +72,27 @@ int LoadBalancerP2::get_threads() const
 /// The thread needs to sieve [low, high[
 bool LoadBalancerP2::get_work(int64_t& low, int64_t& high)
 {
-  LockGuard lockGuard(lock_);
-  print_status();
+  Progress progress;
+  bool is_progress = false;
+  bool is_work;
+
+  {
+    LockGuard lockGuard(lock_);
+    print_status();
+    is_progress = update_progress(progress);
+    is_work = next_work(low, high);
+  }
+
+  // Invoke the progress callback outside of the lock
+  if (is_progress)
+    progress_.report(progress);
 
+  return is_work;
+}
+
+/// Must be called while holding the lock
+bool LoadBalancerP2::next_work(int64_t& low, int64_t& high)
+{
   // Calculate the remaining sieving distance
   low_ = min(low_, sieve_limit_);
   int64_t dist = sieve_limit_ - low_;
@@ -69,25 +100,16 @@ bool LoadBalancerP2::get_work(int64_t& low, int64_t& high)
   // When a single thread is used (and printing is
   // disabled) we can set thread_dist to the entire
   // sieving distance as load balancing is only
-  // useful for multi-threading.
+  // useful for multi-threading. Cancellable
+  // computations and computations that report
+  // their progress keep using multiple chunks.
   if (threads_ == 1)
   {
-    if (!is_print_)
+    if (!is_print_ && !token_ && !progress_)
       thread_dist_ = dist;
   }
   else
   {
-    // Ensure that the thread initialization, i.e. the
-    // computation of PrimePi(low), uses at most 10%
-    // of the entire thread computation.
-    // Since PrimePi(low) uses O(low^(2/3)/log(low)^2) time,
-    // sieving a distance of n = low^(2/3) * 5 uses
-    // O(n log log n) time, which is more than 10x more.
-    double low13 = std::cbrt(low_);
-    int64_t n = (int64_t) (low13 * low13 * 5);
-    min_thread_dist_ = std::max(min_thread_dist_, n);
-    thread_dist_ = max(min_thread_dist_, thread_dist_);
-
     // Reduce the thread distance near to end to keep all
     // threads busy until the computation finishes.
     int64_t max_thread_dist = dist / threads_;
@@ -95,6 +117,9 @@ bool LoadBalancerP2::get_work(int64_t& low, int64_t& high)
       thread_dist_ = max(min_thread_dist_, max_thread_dist);
   }
 
+  if (is_cancelled())
+    low_ = sieve_limit_;
+
   low = low_;
   low_ += thread_dist_;
   low_ = min(low_, sieve_limit_);
@@ -103,6 +128,28 @@ bool LoadBalancerP2::get_work(int64_t& low, int64_t& high)
   return low < sieve_limit_;
 }
 
+/// Must be called while holding the lock. Returns true
+/// if progress has been filled in and needs to be reported.
+///
+bool LoadBalancerP2::update_progress(Progress& progress)
+{
+  if (!progress_.is_due(progress_time_))
+    return false;
+
+  progress.formula = formula_;
+  progress.percent = get_percent(low_, sieve_limit_);
+  progress.remaining_secs = get_remaining_secs(start_time_, progress.percent);
+  return true;
+}
+
+/// Stop handing out work if the pi_async()
+/// computation has been cancelled.
+///
+bool LoadBalancerP2::is_cancelled() const
+{
+  return token_ && token_->is_cancelled();
+}
+
 void LoadBalancerP2::print_status()
 {
   if (is_print_)
@@ -29,6 +29,7 @@
 ///
 
 #include "LoadBalancerS2.hpp"
+#include "primecount.hpp"
 #include "primecount-config.hpp"
 #include "primecount-internal.hpp"
 #include "StatusS2.hpp"
@@ -36,12 +37,17 @@
 #include "imath.hpp"
 #include "int128_t.hpp"
 #include "min.hpp"
+#include "print.hpp"
+#include "to_string.hpp"
 
 #include <stdint.h>
+#include <atomic>
+#include <cmath>
 
 namespace primecount {
 
-LoadBalancerS2::LoadBalancerS2(maxint_t x,
+LoadBalancerS2::LoadBalancerS2(const char* formula,
+                               maxint_t x,
                                int64_t sieve_limit,
                                maxint_t sum_approx,
                                int threads,
@@ -49,7 +55,10 @@ LoadBalancerS2::LoadBalancerS2(maxint_t x,
   sieve_limit_(sieve_limit),
   sum_approx_(sum_approx),
   time_(get_time()),
+  progress_time_(time_),
+  formula_(formula),
   is_print_(is_print),
+  token_(get_cancellation_token()),
   status_(x)
 {
   lock_.init(threads);
@@ -65,6 +74,9 @@ LoadBalancerS2::LoadBalancerS2(maxint_t x,
   int64_t sqrt_limit = isqrt(sieve_limit);
   max_size_ = max(sieve_bytes * numbers_per_byte, sqrt_limit);
 
+  int64_t segments;
+  int64_t segment_size;
+
   // When a single thread is used (and printing
   // is disabled) we can set segment_size to
   // its maximum size as load balancing is only
@@ -72,8 +84,8 @@ LoadBalancerS2::LoadBalancerS2(maxint_t x,
   if (threads == 1 &&
       !is_print)
   {
-    segment_size_ = max_size_;
-    segments_ = 100;
+    segment_size = max_size_;
+    segments = 100;
   }
   else
   {
@@ -81,13 +93,15 @@ LoadBalancerS2::LoadBalancerS2(maxint_t x,
     // most special leaves are in the first few
     // segments and as we need to ensure that all
     // threads are assigned an equal amount of work.
-    segment_size_ = isqrt(isqrt(x));
-    segments_ = 1;
+    segment_size = isqrt(isqrt(x));
+    segments = 1;
   }
 
   int64_t min_size = 1 << 9;
-  segment_size_ = max(min_size, segment_size_);
-  segment_size_ = Sieve::get_segment_size(segment_size_);
+  segment_size = max(min_size, segment_size);
+  segment_size = Sieve::get_segment_size(segment_size);
+  segments_ = segments;
+  segment_size_ = segment_size;
 }
 
 maxint_t LoadBalancerS2::get_sum() const
@@ -95,33 +109,98 @@ maxint_t LoadBalancerS2::get_sum() const
   return sum_;
 }
 
+/// Stop handing out work if the pi_async()
+/// computation has been cancelled.
+///
+bool LoadBalancerS2::is_cancelled() const
+{
+  return token_ && token_->is_cancelled();
+}
+
+/// Assign the next interval [low, low + segments * segment_size[
+/// to the thread. The next interval is reserved using an atomic
+/// fetch_add(), hence threads never have to wait for each other
+/// in get_work(). This matters near the start of the computation
+/// where the intervals are tiny and get_work() is called at a
+/// very high rate. Updating the load balancing settings, the
+/// sum and the status requires a lock. If the lock is currently
+/// held by another thread, the thread's sum is kept in
+/// thread.sum and added in the thread's next call to
+/// get_work(), but the timings of the thread's previous
+/// interval are dropped (i.e. they are not used for load
+/// balancing). This is harmless since the load balancer only
+/// uses the timings of the most recent intervals anyway.
+///
 bool LoadBalancerS2::get_work(ThreadData& thread)
 {
-  LockGuard lockGuard(lock_);
-  sum_ += thread.sum;
+  Progress progress;
+  bool is_progress = false;
 
-  if (is_print_)
   {
-    uint64_t dist = thread.segments * thread.segment_size;
-    uint64_t high = thread.low + dist;
-    status_.print(high, sieve_limit_, sum_, sum_approx_);
+    TryLockGuard lockGuard(lock_);
+    if (lockGuard.owns_lock())
+      is_progress = update(thread, progress);
   }
 
-  update_load_balancing(thread);
+  // Invoke the progress callback outside of the lock
+  if (is_progress)
+    progress_.report(progress);
 
-  thread.low = low_;
-  thread.segments = segments_;
-  thread.segment_size = segment_size_;
-  thread.sum = 0;
+  int64_t segments = segments_.load(std::memory_order_relaxed);
+  int64_t segment_size = segment_size_.load(std::memory_order_relaxed);
+  int64_t dist = segments * segment_size;
+
+  thread.low = low_.fetch_add(dist, std::memory_order_relaxed);
+  thread.segments = segments;
+  thread.segment_size = segment_size;
   thread.secs = 0;
   thread.init_secs = 0;
 
-  low_ += segments_ * segment_size_;
-  bool is_work = thread.low < sieve_limit_;
+  bool is_work = thread.low < sieve_limit_ &&
+                 !is_cancelled();
+
+  // Add the thread's remaining sum before it exits
+  if (!is_work &&
+      thread.sum != 0)
+  {
+    LockGuard lockGuard(lock_);
+    sum_ += thread.sum;
+    thread.sum = 0;
+  }
 
   return is_work;
 }
 
+/// Add the thread's sum, print the status and update
+/// the load balancing settings. Must be called while
+/// holding the lock. Returns true if progress has been
+/// filled in and needs to be reported.
+///
+bool LoadBalancerS2::update(ThreadData& thread, Progress& progress)
+{
+  sum_ += thread.sum;
+  thread.sum = 0;
+
+  uint64_t dist = thread.segments * thread.segment_size;
+  uint64_t high = thread.low + dist;
+
+  if (is_print_)
+    status_.print(high, sieve_limit_, sum_, sum_approx_);
+
+  bool is_progress = progress_.is_due(progress_time_);
+
+  if (is_progress)
+  {
+    progress.formula = formula_;
+    progress.percent = status_.getPercent(high, sieve_limit_, sum_, sum_approx_);
+    progress.remaining_secs = remaining_secs();
+    progress.sum = to_string(sum_);
+  }
+
+  update_load_balancing(thread);
+  return is_progress;
+}
+
 void LoadBalancerS2::update_load_balancing(const ThreadData& thread)
 {
   if (thread.low > max_low_)
@@ -151,9 +230,10 @@ void LoadBalancerS2::update_load_balancing(const ThreadData& thread)
 /// Slowly increase segment_size until it reaches sqrt(sieve_limit)
 void LoadBalancerS2::update_segment_size()
 {
-  segment_size_ += segment_size_ / 16;
-  segment_size_ = min(segment_size_, max_size_);
-  segment_size_ = Sieve::get_segment_size(segment_size_);
+  int64_t segment_size = segment_size_;
+  segment_size += segment_size / 16;
+  segment_size = min(segment_size, max_size_);
+  segment_size_ = Sieve::get_segment_size(segment_size);
 }
 
 /// Increase or decrease the number of segments per thread
@@ -226,20 +306,25 @@ void LoadBalancerS2::update_number_of_segments(const ThreadData& thread)
   factor = in_between(0.5, factor, 2.0);
   double next_runtime = thread.secs * factor;
 
+  int64_t segments = segments_;
+
   if (next_runtime < min_secs)
-    segments_ *= 2;
+    segments *= 2;
   else
   {
-    double new_segments = std::round(segments_ * factor);
-    segments_ = (int64_t) new_segments;
-    segments_ = max(segments_, 1);
+    double new_segments = std::round(segments * factor);
+    segments = (int64_t) new_segments;
+    segments = max(segments, 1);
   }
+
+  segments_ = segments;
 }
 
 /// Remaining seconds till finished
 double LoadBalancerS2::remaining_secs() const
 {
-  double percent = status_.getPercent(low_, sieve_limit_, sum_, sum_approx_);
+  int64_t low = low_.load(std::memory_order_relaxed);
+  double percent = status_.getPercent(low, sieve_limit_, sum_, sum_approx_);
   percent = in_between(10, percent, 100);
   double total_secs = get_time() - time_;
   double secs = total_secs * (100 / percent) - total_secs;
@@ -17,7 +17,9 @@
 #include "PiTable.hpp"
 #include "primecount-internal.hpp"
 #include "primesieve.hpp"
+#include "parallel.hpp"
 #include "pod_vector.hpp"
+#include "TableCache.hpp"
 #include "imath.hpp"
 #include "macros.hpp"
 #include "min.hpp"
@@ -76,15 +78,30 @@ const pod_array<PiTable::pi_t, 64> PiTable::pi_cache_ =
 PiTable::PiTable(uint64_t max_x, int threads) :
   max_x_(max_x)
 {
-  // Initialize PiTable from cache
   uint64_t limit = max_x + 1;
-  pi_.resize(ceil_div(limit, 240));
+  uint64_t size = ceil_div(limit, 240);
+  TableHeader header(240, sizeof(pi_t), max_x, size);
+
+  // Map PiTable from the table cache directory
+  if (is_table_cache(limit))
+  {
+    table_ = (const pi_t*) file_.open("PiTable.bin", header);
+    if (table_)
+      return;
+  }
+
+  // Initialize PiTable from cache
+  pi_.resize(size);
   std::size_t n = min(pi_cache_.size(), pi_.size());
   std::copy_n(&pi_cache_[0], n, &pi_[0]);
+  table_ = pi_.data();
 
   uint64_t cache_limit = pi_cache_.size() * 240;
   if (limit > cache_limit)
     init(limit, cache_limit, threads);
+
+  if (is_table_cache(limit))
+    table_ = file_.save("PiTable.bin", header, pi_);
 }
 
 /// Used if PiTable larger than pi_cache
@@ -101,30 +118,27 @@ void PiTable::init(uint64_t limit,
   thread_dist += 240 - thread_dist % 240;
   counts_.resize(threads);
 
-  #pragma omp parallel num_threads(threads)
+  parallel_region(threads, [&](int t)
   {
-    #pragma omp for
-    for (int t = 0; t < threads; t++)
-    {
-      uint64_t low = cache_limit + thread_dist * t;
-      uint64_t high = low + thread_dist;
-      high = min(high, limit);
-
-      if (low < high)
-        init_bits(low, high, t);
-    }
-
-    #pragma omp for
-    for (int t = 0; t < threads; t++)
-    {
-      uint64_t low = cache_limit + thread_dist * t;
-      uint64_t high = low + thread_dist;
-      high = min(high, limit);
-
-      if (low < high)
-        init_count(low, high, t);
-    }
-  }
+    uint64_t low = cache_limit + thread_dist * t;
+    uint64_t high = low + thread_dist;
+    high = min(high, limit);
+
+    if (low < high)
+      init_bits(low, high, t);
+  });
+
+  // init_count() requires the prime
+  // counts of all previous threads.
+  parallel_region(threads, [&](int t)
+  {
+    uint64_t low = cache_limit + thread_dist * t;
+    uint64_t high = low + thread_dist;
+    high = min(high, limit);
+
+    if (low < high)
+      init_count(low, high, t);
+  });
 }
 
 /// Each thread computes PrimePi [low, high[
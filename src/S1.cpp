@@ -18,6 +18,7 @@
 #include "generate.hpp"
 #include "imath.hpp"
 #include "int128_t.hpp"
+#include "parallel.hpp"
 #include "pod_vector.hpp"
 #include "print.hpp"
 #include "S.hpp"
@@ -76,12 +77,19 @@ X S1_OpenMP(X x,
   int64_t pi_y = primes.size() - 1;
   X s1 = phi_tiny(x, c);
 
-  #pragma omp parallel for schedule(static, 1) num_threads(threads) reduction (+: s1)
-  for (int64_t b = c + 1; b <= pi_y; b++)
+  // for (b = c + 1; b <= pi_y; b++)
+  s1 += parallel_sum<X>(threads, [&](int thread_num)
   {
-    s1 -= phi_tiny(x / primes[b], c);
-    s1 += S1_thread<1>(x, y, b, c, (X) primes[b], primes);
-  }
+    X s1 = 0;
+
+    for (int64_t b = c + 1 + thread_num; b <= pi_y; b += threads)
+    {
+      s1 -= phi_tiny(x / primes[b], c);
+      s1 += S1_thread<1>(x, y, b, c, (X) primes[b], primes);
+    }
+
+    return s1;
+  });
 
   return s1;
 }
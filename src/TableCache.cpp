@@ -0,0 +1,273 @@
+///
+/// @file  TableCache.cpp
+/// @brief Persistent on-disk cache for the PiTable, FactorTable
+///        and FactorTableD lookup tables. On Unix-like operating
+///        systems the table files are mapped into memory using
+///        mmap(), on other operating systems the table files are
+///        read into memory.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "TableCache.hpp"
+#include "primecount.hpp"
+#include "primecount-internal.hpp"
+#include "macros.hpp"
+#include "pod_vector.hpp"
+
+#include <stdint.h>
+#include <cstdio>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+
+#if __has_include(<sys/mman.h>) && \
+    __has_include(<sys/stat.h>) && \
+    __has_include(<fcntl.h>) && \
+    __has_include(<unistd.h>)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #define HAVE_MMAP
+#endif
+
+namespace {
+
+// Default table cache directory, used if the Config
+// of the current computation has no table cache dir.
+std::string table_cache_dir_;
+std::mutex table_cache_mutex_;
+
+struct MemoryTable
+{
+  primecount::TableHeader header;
+  std::shared_ptr<const void> table;
+};
+
+// Memory table cache, at most 1 table per table name
+std::atomic<bool> memory_table_cache_(false);
+std::map<std::string, MemoryTable> memory_tables_;
+
+std::string get_path(const std::string& name)
+{
+  std::string path = primecount::get_table_cache_dir();
+
+  if (path.back() != '/' &&
+      path.back() != '\\')
+    path += '/';
+
+  return path + name;
+}
+
+bool is_match(const primecount::TableHeader& file,
+              const primecount::TableHeader& header)
+{
+  return std::memcmp(file.magic, header.magic, sizeof(header.magic)) == 0 &&
+         file.version == header.version &&
+         file.wheel == header.wheel &&
+         file.entry_size == header.entry_size &&
+         file.y == header.y &&
+         file.limit >= header.limit &&
+         file.size >= header.size;
+}
+
+} // namespace
+
+namespace primecount {
+
+void set_table_cache_dir(const std::string& dir)
+{
+  std::lock_guard<std::mutex> lock(table_cache_mutex_);
+  table_cache_dir_ = dir;
+}
+
+/// The table cache directory of the current
+/// pi(x, config) computation of this thread.
+///
+std::string get_table_cache_dir()
+{
+  const Config* config = get_config();
+  if (config && !config->table_cache_dir.empty())
+    return config->table_cache_dir;
+
+  std::lock_guard<std::mutex> lock(table_cache_mutex_);
+  return table_cache_dir_;
+}
+
+/// Lookup tables of numbers < 10^7 are generated in a
+/// few milliseconds, caching these is not worth it.
+///
+bool is_table_cache(uint64_t limit)
+{
+  return limit >= (uint64_t) 1e7 &&
+         (is_memory_table_cache() ||
+          !get_table_cache_dir().empty());
+}
+
+bool is_memory_table_cache()
+{
+  return memory_table_cache_;
+}
+
+/// Disabling the memory table cache
+/// frees the tables of the cache.
+///
+void set_memory_table_cache(bool enable)
+{
+  std::lock_guard<std::mutex> lock(table_cache_mutex_);
+  memory_table_cache_ = enable;
+  if (!enable)
+    memory_tables_.clear();
+}
+
+/// The table replaces the previous table of the same name,
+/// tables that are still in use are freed once their
+/// last TableFile has been destroyed.
+///
+void save_memory_table(const std::string& name,
+                       const TableHeader& header,
+                       const std::shared_ptr<const void>& table)
+{
+  std::lock_guard<std::mutex> lock(table_cache_mutex_);
+  if (memory_table_cache_)
+    memory_tables_[name] = MemoryTable{header, table};
+}
+
+TableFile::~TableFile()
+{
+#if defined(HAVE_MMAP)
+  if (map_)
+    munmap(map_, size_);
+#endif
+}
+
+const void* TableFile::open(const std::string& name,
+                            const TableHeader& header)
+{
+  if (is_memory_table_cache())
+  {
+    std::lock_guard<std::mutex> lock(table_cache_mutex_);
+    auto iter = memory_tables_.find(name);
+    if (iter != memory_tables_.end() &&
+        is_match(iter->second.header, header))
+    {
+      memory_ = iter->second.table;
+      return memory_.get();
+    }
+  }
+
+  if (get_table_cache_dir().empty())
+    return nullptr;
+
+  std::string path = get_path(name);
+  TableHeader file;
+
+#if defined(HAVE_MMAP)
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    return nullptr;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      (uint64_t) st.st_size < sizeof(TableHeader))
+  {
+    close(fd);
+    return nullptr;
+  }
+
+  std::size_t size = (std::size_t) st.st_size;
+  void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (map == MAP_FAILED)
+    return nullptr;
+
+  std::memcpy(&file, map, sizeof(TableHeader));
+  uint64_t bytes = sizeof(TableHeader) + file.size * file.entry_size;
+
+  if (!is_match(file, header) || bytes > size)
+  {
+    munmap(map, size);
+    return nullptr;
+  }
+
+  map_ = map;
+  size_ = size;
+  return (const char*) map_ + sizeof(TableHeader);
+#else
+  FILE* fp = std::fopen(path.c_str(), "rb");
+  if (!fp)
+    return nullptr;
+
+  if (std::fread(&file, sizeof(TableHeader), 1, fp) != 1 ||
+      !is_match(file, header))
+  {
+    std::fclose(fp);
+    return nullptr;
+  }
+
+  // We only read the entries of the requested table
+  std::size_t bytes = (std::size_t) (header.size * header.entry_size);
+  buffer_.resize(ceil_div(bytes, sizeof(uint64_t)));
+  std::size_t read = std::fread(buffer_.data(), 1, bytes, fp);
+  std::fclose(fp);
+
+  if (read != bytes)
+  {
+    buffer_.deallocate();
+    return nullptr;
+  }
+
+  return buffer_.data();
+#endif
+}
+
+/// Save the table to the table cache directory. The table is
+/// first written to a temporary file which is then renamed,
+/// this way other processes never see partially written files.
+/// If the table cannot be saved we print a warning and continue
+/// without caching, the table itself has already been generated.
+///
+void save_table(const std::string& name,
+                const TableHeader& header,
+                const void* table)
+{
+  std::string path = get_path(name);
+  std::string tmp = path + ".tmp" + std::to_string(std::random_device()());
+  FILE* fp = std::fopen(tmp.c_str(), "wb");
+
+  if (!fp)
+  {
+    std::cerr << "Warning: failed to create table file " << tmp << std::endl;
+    return;
+  }
+
+  std::size_t bytes = (std::size_t) (header.size * header.entry_size);
+  bool ok = std::fwrite(&header, sizeof(TableHeader), 1, fp) == 1 &&
+            std::fwrite(table, 1, bytes, fp) == bytes;
+  ok &= std::fclose(fp) == 0;
+
+  if (ok && std::rename(tmp.c_str(), path.c_str()) != 0)
+  {
+    // On Windows rename() fails if the file exists
+    std::remove(path.c_str());
+    ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+  }
+
+  if (!ok)
+  {
+    std::remove(tmp.c_str());
+    std::cerr << "Warning: failed to write table file " << path << std::endl;
+  }
+}
+
+} // namespace
@@ -0,0 +1,83 @@
+///
+/// @file  TaskScheduler.cpp
+/// @brief The TaskScheduler splits the expensive iterations of
+///        an outer loop into multiple tasks that each process a
+///        sub-range of the inner loop. This way the first, most
+///        expensive outer loop iterations are processed by
+///        multiple threads in parallel and the remaining threads
+///        pick up the many cheap tasks in the meantime.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "TaskScheduler.hpp"
+#include "primecount-internal.hpp"
+#include "imath.hpp"
+#include "min.hpp"
+#include "pod_vector.hpp"
+
+#include <stdint.h>
+#include <cmath>
+
+namespace primecount {
+
+void TaskScheduler::add(int64_t b,
+                        int64_t start,
+                        int64_t stop,
+                        double cost)
+{
+  stop = max(start, stop);
+  tasks_.push_back(Task{b, start, stop});
+  costs_.push_back(cost);
+}
+
+void TaskScheduler::split(int threads)
+{
+  if (threads <= 1)
+    return;
+
+  double total_cost = 0;
+  for (double cost : costs_)
+    total_cost += cost;
+
+  // Using more tasks per thread improves load
+  // balancing but also adds some overhead.
+  double tasks_per_thread = 16;
+  double max_cost = total_cost / (threads * tasks_per_thread);
+
+  if (max_cost <= 0)
+    return;
+
+  pod_vector<Task> tasks;
+  tasks.reserve(tasks_.size());
+
+  for (std::size_t j = 0; j < tasks_.size(); j++)
+  {
+    Task task = tasks_[j];
+    int64_t dist = task.stop - task.start;
+    int64_t parts = (int64_t) std::ceil(costs_[j] / max_cost);
+    parts = in_between(1, parts, max(dist, 1));
+    int64_t part_dist = ceil_div(dist, parts);
+
+    // The first part of each outer loop iteration b is
+    // always added, even if the inner loop is empty.
+    // Hence each b is processed exactly once.
+    int64_t start = task.start;
+
+    do
+    {
+      int64_t stop = min(start + part_dist, task.stop);
+      tasks.push_back(Task{task.b, start, stop});
+      start = stop;
+    }
+    while (start < task.stop);
+  }
+
+  tasks_ = std::move(tasks);
+  costs_.clear();
+}
+
+} // namespace
@@ -0,0 +1,214 @@
+///
+/// @file  ThreadPool.cpp
+/// @brief Persistent thread pool used by parallel_region() if
+///        primecount has been compiled without OpenMP. A single
+///        pi(x) computation opens many short parallel regions
+///        (PiTable, FactorTable, Phi0, AC, B, D, ...). Creating
+///        new threads for each of these regions noticeably
+///        increases the runtime of small and medium
+///        computations. Hence the threads are created once and
+///        then reused by all parallel regions. (When using
+///        OpenMP this is not needed because the OpenMP runtime
+///        already reuses its threads.)
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "parallel.hpp"
+
+#if !defined(_OPENMP)
+
+#include <stdint.h>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// True if the calling thread is currently executing
+// func(thread_num) of a parallel region.
+thread_local bool in_parallel_region_ = false;
+
+/// Marks the calling thread as being inside a parallel
+/// region and stores the first exception thrown by func.
+///
+void run_func(const std::function<void(int)>& func,
+              int thread_num,
+              std::exception_ptr& exception,
+              std::mutex& mutex)
+{
+  in_parallel_region_ = true;
+
+  try
+  {
+    func(thread_num);
+  }
+  catch (...)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!exception)
+      exception = std::current_exception();
+  }
+
+  in_parallel_region_ = false;
+}
+
+class ThreadPool
+{
+public:
+  ~ThreadPool();
+  bool try_run(int threads, const std::function<void(int)>& func);
+
+private:
+  void worker(int thread_num);
+
+  // Only 1 parallel region at a time may use the pool
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  std::vector<std::thread> workers_;
+  const std::function<void(int)>* func_ = nullptr;
+  std::exception_ptr exception_;
+  uint64_t generation_ = 0;
+  int threads_ = 0;
+  int pending_ = 0;
+  bool stop_ = false;
+};
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+
+  start_.notify_all();
+
+  for (std::thread& thread : workers_)
+    thread.join();
+}
+
+/// Worker thread_num executes func(thread_num) of
+/// all parallel regions with threads > thread_num.
+///
+void ThreadPool::worker(int thread_num)
+{
+  uint64_t generation = 0;
+
+  while (true)
+  {
+    const std::function<void(int)>* func;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock, [&] { return stop_ || generation_ != generation; });
+
+      if (stop_)
+        return;
+
+      generation = generation_;
+      if (thread_num >= threads_)
+        continue;
+
+      func = func_;
+    }
+
+    run_func(*func, thread_num, exception_, mutex_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pending_ == 0)
+      done_.notify_one();
+  }
+}
+
+/// Returns false if the pool is currently used by
+/// concurrent primecount calls from other threads.
+/// If func throws an exception, we wait until all
+/// workers have finished and then rethrow it.
+///
+bool ThreadPool::try_run(int threads,
+                         const std::function<void(int)>& func)
+{
+  std::unique_lock<std::mutex> run_lock(run_mutex_, std::try_to_lock);
+  if (!run_lock.owns_lock())
+    return false;
+
+  // The calling thread executes func(0)
+  for (int t = (int) workers_.size() + 1; t < threads; t++)
+    workers_.emplace_back(&ThreadPool::worker, this, t);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    func_ = &func;
+    exception_ = nullptr;
+    threads_ = threads;
+    pending_ = threads - 1;
+    generation_++;
+  }
+
+  start_.notify_all();
+  run_func(func, 0, exception_, mutex_);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [&] { return pending_ == 0; });
+  func_ = nullptr;
+  std::exception_ptr exception = exception_;
+  exception_ = nullptr;
+  lock.unlock();
+
+  if (exception)
+    std::rethrow_exception(exception);
+
+  return true;
+}
+
+} // namespace
+
+namespace primecount {
+
+void thread_pool_run(int threads,
+                     const std::function<void(int)>& func)
+{
+  // Nested parallel region, the calling thread is
+  // already one of the threads of the outer region.
+  if (in_parallel_region_)
+  {
+    for (int t = 0; t < threads; t++)
+      func(t);
+    return;
+  }
+
+  // Reuse the threads of the persistent thread pool
+  static ThreadPool pool;
+  if (pool.try_run(threads, func))
+    return;
+
+  // The thread pool is busy (concurrent primecount
+  // calls), use new threads instead.
+  std::vector<std::thread> pool_threads;
+  std::exception_ptr exception;
+  std::mutex mutex;
+  pool_threads.reserve(threads - 1);
+
+  for (int t = 1; t < threads; t++)
+    pool_threads.emplace_back(run_func, std::cref(func), t, std::ref(exception), std::ref(mutex));
+
+  run_func(func, 0, exception, mutex);
+
+  for (std::thread& thread : pool_threads)
+    thread.join();
+
+  if (exception)
+    std::rethrow_exception(exception);
+}
+
+} // namespace
+
+#endif
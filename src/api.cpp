@@ -18,24 +18,58 @@
 #include "to_string.hpp"
 
 #include <cmath>
+#include <future>
 #include <limits>
 #include <string>
 #include <stdint.h>
 
 #ifdef _OPENMP
   #include <omp.h>
+#else
+  #include <thread>
 #endif
 
 namespace {
 
+int threads_ = 0;
+
+/// Without OpenMP primecount uses std::thread
+/// (see parallel.hpp).
+///
+int max_threads()
+{
 #ifdef _OPENMP
-  int threads_ = 0;
+  return std::max(1, omp_get_max_threads());
+#else
+  return std::max(1u, std::thread::hardware_concurrency());
 #endif
+}
+
+/// pi_async() runs in a new thread which does not inherit the
+/// caller's thread_local Config (see ConfigGuard), hence we
+/// copy the caller's Config and reinstall it in the new thread.
+///
+primecount::Config async_config()
+{
+  const primecount::Config* config = primecount::get_config();
+  primecount::Config copy = config ? *config : primecount::Config();
+  copy.threads = primecount::config_threads(copy);
+  return copy;
+}
 
 } // namespace
 
 namespace primecount {
 
+/// Number of threads of a pi(x, config) computation
+int config_threads(const Config& config)
+{
+  if (config.threads > 0)
+    return in_between(1, config.threads, max_threads());
+  else
+    return get_num_threads();
+}
+
 int64_t pi_cache(int64_t x, bool is_print)
 {
   if (is_print)
@@ -72,6 +106,12 @@ int64_t pi(int64_t x, int threads)
   return pi_gourdon_64(x, threads);
 }
 
+int64_t pi(int64_t x, const Config& config)
+{
+  ConfigGuard guard(config);
+  return pi(x, config_threads(config));
+}
+
 /// Used internally for initialization
 int64_t pi_noprint(int64_t x, int threads)
 {
@@ -110,6 +150,12 @@ std::string pi(const std::string& x)
   return pi(x, get_num_threads());
 }
 
+std::string pi(const std::string& x, const Config& config)
+{
+  ConfigGuard guard(config);
+  return pi(x, config_threads(config));
+}
+
 std::string pi(const std::string& x, int threads)
 {
   maxint_t n = to_maxint(x);
@@ -117,6 +163,49 @@ std::string pi(const std::string& x, int threads)
   return to_string(res);
 }
 
+std::string pi(const std::string& x, const std::string& y)
+{
+  return pi(x, y, get_num_threads());
+}
+
+std::string pi(const std::string& x, const std::string& y, int threads)
+{
+  maxint_t low = to_maxint(x);
+  maxint_t high = to_maxint(y);
+
+  if (high <= low)
+    return "0";
+
+  maxint_t res = count_primes(low + 1, high, threads);
+  return to_string(res);
+}
+
+std::future<int64_t> pi_async(int64_t x, const CancellationToken& token)
+{
+  Config config = async_config();
+
+  return std::async(std::launch::async, [=]() {
+    ConfigGuard configGuard(config);
+    CancellationGuard guard(token);
+    int64_t res = pi(x, config.threads);
+    check_cancelled();
+    return res;
+  });
+}
+
+std::future<std::string> pi_async(const std::string& x, const CancellationToken& token)
+{
+  Config config = async_config();
+
+  return std::async(std::launch::async, [=]() {
+    ConfigGuard configGuard(config);
+    CancellationGuard guard(token);
+    std::string res = pi(x, config.threads);
+    check_cancelled();
+    return res;
+  });
+}
+
 int64_t pi_deleglise_rivat(int64_t x, int threads)
 {
   return pi_deleglise_rivat_64(x, threads);
@@ -154,11 +243,41 @@ int64_t nth_prime(int64_t n)
   return nth_prime(n, get_num_threads());
 }
 
+int64_t nth_prime(int64_t n, const Config& config)
+{
+  ConfigGuard guard(config);
+  return nth_prime(n, config_threads(config));
+}
+
+std::string nth_prime(const std::string& n)
+{
+  return nth_prime(n, get_num_threads());
+}
+
+std::string nth_prime(const std::string& n, const Config& config)
+{
+  ConfigGuard guard(config);
+  return nth_prime(n, config_threads(config));
+}
+
+std::string nth_prime(const std::string& n, int threads)
+{
+  maxint_t x = to_maxint(n);
+  maxint_t res = nth_prime(x, threads);
+  return to_string(res);
+}
+
 int64_t phi(int64_t x, int64_t a)
 {
   return phi(x, a, get_num_threads());
 }
 
+int64_t phi(int64_t x, int64_t a, const Config& config)
+{
+  ConfigGuard guard(config);
+  return phi(x, a, config_threads(config));
+}
+
 std::string primecount_version()
 {
   return PRIMECOUNT_VERSION;
@@ -194,21 +313,15 @@ std::string get_max_x()
 
 int get_num_threads()
 {
-#ifdef _OPENMP
   if (threads_)
     return threads_;
   else
-    return std::max(1, omp_get_max_threads());
-#else
-  return 1;
-#endif
+    return max_threads();
 }
 
 void set_num_threads(int threads)
 {
-#ifdef _OPENMP
-  threads_ = in_between(1, threads, omp_get_max_threads());
-#endif
+  threads_ = in_between(1, threads, max_threads());
   primesieve::set_num_threads(threads);
 }
 
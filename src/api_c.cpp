@@ -18,6 +18,9 @@
 #include <string>
 #include <exception>
 #include <iostream>
+#include <future>
+#include <thread>
+#include <utility>
 
 int64_t primecount_pi(int64_t x)
 {
@@ -71,6 +74,76 @@ int primecount_pi_str(const char* x, char* res, size_t len)
   }
 }
 
+struct primecount_token
+{
+  primecount::CancellationToken token;
+};
+
+primecount_token* primecount_token_create()
+{
+  try
+  {
+    return new primecount_token;
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "primecount_token_create: " << e.what() << std::endl;
+    return nullptr;
+  }
+}
+
+void primecount_token_cancel(primecount_token* token)
+{
+  if (token)
+    token->token.cancel();
+}
+
+void primecount_token_destroy(primecount_token* token)
+{
+  delete token;
+}
+
+int primecount_pi_async(const char* x,
+                        primecount_token* token,
+                        primecount_callback callback,
+                        void* data)
+{
+  try
+  {
+    if (!x)
+      throw primecount::primecount_error("x must not be a NULL pointer");
+
+    if (!callback)
+      throw primecount::primecount_error("callback must not be a NULL pointer");
+
+    primecount::CancellationToken cancel;
+    if (token)
+      cancel = token->token;
+
+    auto future = primecount::pi_async(std::string(x), cancel);
+
+    std::thread([callback, data](std::future<std::string> res) {
+      try
+      {
+        std::string pix = res.get();
+        callback(pix.c_str(), data);
+      }
+      catch(const std::exception& e)
+      {
+        std::cerr << "primecount_pi_async: " << e.what() << std::endl;
+        callback(nullptr, data);
+      }
+    }, std::move(future)).detach();
+
+    return 0;
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "primecount_pi_async: " << e.what() << std::endl;
+    return -1;
+  }
+}
+
 int64_t primecount_nth_prime(int64_t n)
 {
   try
@@ -84,6 +157,58 @@ int64_t primecount_nth_prime(int64_t n)
   }
 }
 
+int primecount_nth_prime_str(const char* n, char* res, size_t len)
+{
+  try
+  {
+    if (!n)
+      throw primecount::primecount_error("n must not be a NULL pointer");
+
+    if (!res)
+      throw primecount::primecount_error("res must not be a NULL pointer");
+
+    std::string str(n);
+    std::string prime = primecount::nth_prime(str);
+
+    // +1 required to add null at the end of the string
+    if (len < prime.length() + 1)
+    {
+      std::ostringstream oss;
+      oss << "res buffer too small, res.len = " << len << " < required = " << prime.length() + 1;
+      throw primecount::primecount_error(oss.str());
+    }
+
+    prime.copy(res, prime.length());
+    // std::string::copy does not append a null character
+    // at the end of the copied content.
+    res[prime.length()] = '\0';
+
+    return (int) prime.length();
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "primecount_nth_prime_str: " << e.what() << std::endl;
+
+    if (res && len > 0)
+      res[0] = '\0';
+
+    return -1;
+  }
+}
+
+int64_t primecount_count_primes(int64_t a, int64_t b)
+{
+  try
+  {
+    return primecount::count_primes(a, b);
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "primecount_count_primes: " << e.what() << std::endl;
+    return -1;
+  }
+}
+
 int64_t primecount_phi(int64_t x, int64_t a)
 {
   try
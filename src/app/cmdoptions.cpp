@@ -20,9 +20,11 @@
 #include <stdint.h>
 #include <cstddef>
 #include <map>
+#include <sstream>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace {
 
@@ -86,14 +88,49 @@ bool isOption(const std::string& str)
   return false;
 }
 
+/// Parse --grid=x0:step:count
+void optionGrid(Option& opt,
+                CmdOptions& opts,
+                pod_vector<maxint_t>& numbers)
+{
+  std::size_t pos1 = opt.val.find(':');
+  std::size_t pos2 = opt.val.rfind(':');
+
+  if (pos1 == std::string::npos ||
+      pos1 == pos2)
+    throw primecount_error("invalid option '" + opt.opt + "=" + opt.val + "', expected x0:step:count");
+
+  Option x0 = opt;
+  Option step = opt;
+  Option count = opt;
+  x0.val = opt.val.substr(0, pos1);
+  step.val = opt.val.substr(pos1 + 1, pos2 - (pos1 + 1));
+  count.val = opt.val.substr(pos2 + 1);
+
+  opts.grid = true;
+  numbers.push_back(x0.to<maxint_t>());
+  opts.step = step.to<maxint_t>();
+  opts.count = count.to<int64_t>();
+}
+
+/// The status of a query is only enabled
+/// while the query is computed (worktodo.cpp).
+///
 void optionStatus(Option& opt,
-                  CmdOptions& opts)
+                  CmdOptions& opts,
+                  bool isQuery)
 {
-  set_print(true);
+  opts.status = true;
   opts.time = true;
 
   if (!opt.val.empty())
-    set_status_precision(opt.to<int>());
+    opts.status_precision = opt.to<int>();
+
+  if (!isQuery)
+  {
+    set_print(true);
+    set_status_precision(opts.status_precision);
+  }
 }
 
 /// Parse the next command-line option.
@@ -218,12 +255,27 @@ void help(int exitCode);
 void version();
 void test();
 
-CmdOptions parseOptions(int argc, char* argv[])
+/// Set the threads and alpha tuning factors
+/// of the command-line options.
+///
+void setConfig(const Config& config)
 {
-  // No command-line options provided
-  if (argc <= 1)
-    help(/* exitCode */ 1);
+  if (config.threads > 0)
+    set_num_threads(config.threads);
+
+  set_alpha(config.alpha);
+  set_alpha_y(config.alpha_y);
+  set_alpha_z(config.alpha_z);
+  set_table_cache_dir(config.table_cache_dir);
+}
 
+/// Parse the command-line options. If isQuery = true the
+/// options are a query of the --server mode, these may only
+/// select the function, the numbers and the settings (e.g.
+/// threads) of the current query.
+///
+CmdOptions parse(int argc, char* argv[], bool isQuery)
+{
   /// primecount command-line options
   const std::map<std::string, std::pair<OptionID, IsParam>> optionMap =
   {
@@ -239,6 +291,7 @@ CmdOptions parseOptions(int argc, char* argv[])
     { "--gourdon", std::make_pair(OPTION_GOURDON, NO_PARAM) },
     { "--gourdon-64", std::make_pair(OPTION_GOURDON_64, NO_PARAM) },
     { "--gourdon-128", std::make_pair(OPTION_GOURDON_128, NO_PARAM) },
+    { "--grid", std::make_pair(OPTION_GRID, REQUIRED_PARAM) },
     { "-h", std::make_pair(OPTION_HELP, NO_PARAM) },
     { "--help", std::make_pair(OPTION_HELP, NO_PARAM) },
     { "-l", std::make_pair(OPTION_LEGENDRE, NO_PARAM) },
@@ -267,6 +320,7 @@ CmdOptions parseOptions(int argc, char* argv[])
     { "--S2-easy", std::make_pair(OPTION_S2_EASY, NO_PARAM) },
     { "--S2-hard", std::make_pair(OPTION_S2_HARD, NO_PARAM) },
     { "--S2-trivial", std::make_pair(OPTION_S2_TRIVIAL, NO_PARAM) },
+    { "--server", std::make_pair(OPTION_SERVER, NO_PARAM) },
     { "--AC", std::make_pair(OPTION_AC, NO_PARAM) },
     { "-B", std::make_pair(OPTION_B, NO_PARAM) },
     { "--B", std::make_pair(OPTION_B, NO_PARAM) },
@@ -276,38 +330,71 @@ CmdOptions parseOptions(int argc, char* argv[])
     { "--Sigma", std::make_pair(OPTION_SIGMA, NO_PARAM) },
     { "-s", std::make_pair(OPTION_STATUS, OPTIONAL_PARAM) },
     { "--status", std::make_pair(OPTION_STATUS, OPTIONAL_PARAM) },
+    { "--table-cache-dir", std::make_pair(OPTION_TABLE_CACHE_DIR, REQUIRED_PARAM) },
     { "--test", std::make_pair(OPTION_TEST, NO_PARAM) },
     { "--time", std::make_pair(OPTION_TIME, NO_PARAM) },
     { "-t", std::make_pair(OPTION_THREADS, REQUIRED_PARAM) },
     { "--threads", std::make_pair(OPTION_THREADS, REQUIRED_PARAM) },
     { "-v", std::make_pair(OPTION_VERSION, NO_PARAM) },
-    { "--version", std::make_pair(OPTION_VERSION, NO_PARAM) }
+    { "--version", std::make_pair(OPTION_VERSION, NO_PARAM) },
+    { "--worktodo", std::make_pair(OPTION_WORKTODO, REQUIRED_PARAM) }
   };
 
   CmdOptions opts;
   pod_vector<maxint_t> numbers;
+  bool isTest = false;
 
   for (int i = 1; i < argc; i++)
   {
     Option opt = parseOption(argc, argv, i, optionMap);
     OptionID optionID = optionMap.at(opt.opt).first;
 
+    // These options modify the global state or compute
+    // multiple results and hence cannot be used in queries.
+    if (isQuery &&
+        (optionID == OPTION_GRID ||
+         optionID == OPTION_HELP ||
+         optionID == OPTION_SERVER ||
+         optionID == OPTION_TABLE_CACHE_DIR ||
+         optionID == OPTION_TEST ||
+         optionID == OPTION_VERSION ||
+         optionID == OPTION_WORKTODO))
+      throw primecount_error("option '" + opt.opt + "' not supported in queries");
+
     switch (optionID)
     {
-      case OPTION_ALPHA:   set_alpha(opt.to<double>()); break;
-      case OPTION_ALPHA_Y: set_alpha_y(opt.to<double>()); break;
-      case OPTION_ALPHA_Z: set_alpha_z(opt.to<double>()); break;
+      case OPTION_ALPHA:   opts.config.alpha = opt.to<double>(); break;
+      case OPTION_ALPHA_Y: opts.config.alpha_y = opt.to<double>(); break;
+      case OPTION_ALPHA_Z: opts.config.alpha_z = opt.to<double>(); break;
+      case OPTION_GRID:    optionGrid(opt, opts, numbers); break;
       case OPTION_NUMBER:  numbers.push_back(opt.to<maxint_t>()); break;
-      case OPTION_THREADS: set_num_threads(opt.to<int>()); break;
+      case OPTION_THREADS: opts.config.threads = opt.to<int>(); break;
       case OPTION_HELP:    help(/* exitCode */ 0); break;
-      case OPTION_STATUS:  optionStatus(opt, opts); break;
+      case OPTION_SERVER:  opts.server = true; break;
+      case OPTION_STATUS:  optionStatus(opt, opts, isQuery); break;
+      case OPTION_TABLE_CACHE_DIR: opts.config.table_cache_dir = opt.val; break;
       case OPTION_TIME:    opts.time = true; break;
-      case OPTION_TEST:    test(); break;
+      case OPTION_TEST:    isTest = true; break;
       case OPTION_VERSION: version(); break;
+      case OPTION_WORKTODO: opts.worktodo = opt.val; break;
       default:             opts.option = optionID;
     }
   }
 
+  // The settings of a query only apply to
+  // that query (see server() in main.cpp).
+  if (!isQuery)
+    setConfig(opts.config);
+
+  if (isTest)
+    test();
+
+  // In --server and --worktodo mode
+  // x is read from stdin or a file.
+  if (opts.server ||
+      !opts.worktodo.empty())
+    return opts;
+
   if (opts.option == OPTION_PHI)
   {
     if (numbers.size() < 2)
@@ -318,9 +405,44 @@ CmdOptions parseOptions(int argc, char* argv[])
   if (numbers.empty())
     throw primecount_error("missing x number");
 
+  // A query computes a single result
+  std::size_t max_numbers = (opts.option == OPTION_PHI) ? 2 : 1;
+  if (isQuery && numbers.size() > max_numbers)
+    throw primecount_error("a query may only contain 1 number (2 numbers for --phi)");
+
   opts.x = numbers[0];
+  opts.numbers.assign(numbers.begin(), numbers.end());
 
   return opts;
 }
 
+CmdOptions parseOptions(int argc, char* argv[])
+{
+  // No command-line options provided
+  if (argc <= 1)
+    help(/* exitCode */ 1);
+
+  bool isQuery = false;
+  return parse(argc, argv, isQuery);
+}
+
+/// Parse a query of the --server mode, a query uses
+/// the same syntax as the command-line options
+/// e.g. "1e15 --threads=4" or "--phi 1000 10".
+///
+CmdOptions parseQuery(const std::string& query)
+{
+  std::istringstream iss(query);
+  std::vector<std::string> args = { "primecount" };
+  std::vector<char*> argv;
+
+  for (std::string arg; iss >> arg;)
+    args.push_back(arg);
+  for (std::string& arg : args)
+    argv.push_back(&arg[0]);
+
+  bool isQuery = true;
+  return parse((int) argv.size(), argv.data(), isQuery);
+}
+
 } // namespace
@@ -10,8 +10,12 @@
 #ifndef CMDOPTIONS_HPP
 #define CMDOPTIONS_HPP
 
+#include "primecount.hpp"
 #include "int128_t.hpp"
+
 #include <stdint.h>
+#include <string>
+#include <vector>
 
 namespace primecount {
 
@@ -27,6 +31,7 @@ enum OptionID
   OPTION_GOURDON,
   OPTION_GOURDON_64,
   OPTION_GOURDON_128,
+  OPTION_GRID,
   OPTION_HELP,
   OPTION_LEGENDRE,
   OPTION_LEHMER,
@@ -50,27 +55,46 @@ enum OptionID
   OPTION_S2_EASY,
   OPTION_S2_HARD,
   OPTION_S2_TRIVIAL,
+  OPTION_SERVER,
   OPTION_AC,
   OPTION_B,
   OPTION_D,
   OPTION_PHI0,
   OPTION_SIGMA,
   OPTION_STATUS,
+  OPTION_TABLE_CACHE_DIR,
   OPTION_TEST,
   OPTION_TIME,
   OPTION_THREADS,
-  OPTION_VERSION
+  OPTION_VERSION,
+  OPTION_WORKTODO
 };
 
 struct CmdOptions
 {
   maxint_t x = -1;
   int64_t a = -1;
+  /// All numbers e.g. primecount 1e15 2e15 3e15
+  std::vector<maxint_t> numbers;
   int option = OPTION_DEFAULT;
+  /// --grid=x0:step:count, x = x0
+  bool grid = false;
+  maxint_t step = 0;
+  int64_t count = 0;
   bool time = false;
+  /// -s, --status[=NUM]
+  bool status = false;
+  int status_precision = -1;
+  bool server = false;
+  std::string worktodo;
+  /// Threads and alpha tuning factors
+  Config config;
 };
 
 CmdOptions parseOptions(int, char**);
+CmdOptions parseQuery(const std::string& query);
+maxint_t compute(const CmdOptions& opt, int threads);
+void worktodo(const CmdOptions& opts);
 
 } // namespace
 
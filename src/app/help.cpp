@@ -26,25 +26,34 @@ void help(int exitCode)
     "  -d, --deleglise-rivat  Count primes using the Deleglise-Rivat algorithm\n"
     "  -g, --gourdon          Count primes using Xavier Gourdon's algorithm.\n"
     "                         This is the default algorithm.\n"
+    "      --grid=X0:STEP:NUM Print x and pi(x) for x = X0 + i * STEP with\n"
+    "                         0 <= i < NUM, one line per x\n"
     "  -l, --legendre         Count primes using Legendre's formula\n"
     "      --lehmer           Count primes using Lehmer's formula\n"
     "      --lmo              Count primes using Lagarias-Miller-Odlyzko\n"
     "  -m, --meissel          Count primes using Meissel's formula\n"
     "      --Li               Approximate pi(x) using the logarithmic integral\n"
     "      --Li-inverse       Approximate the nth prime using Li^-1(x)\n"
-    "  -n, --nth-prime        Calculate the nth prime\n"
+    "  -n, --nth-prime        Calculate the nth prime (n <= 10^29)\n"
     "  -p, --primesieve       Count primes using the sieve of Eratosthenes\n"
     "      --phi <X> <A>      phi(x, a) counts the numbers <= x that are not\n"
     "                         divisible by any of the first a primes\n"
     "      --Ri               Approximate pi(x) using Riemann R\n"
     "      --Ri-inverse       Approximate the nth prime using Ri^-1(x)\n"
+    "      --server           Read queries from stdin (one per line) e.g.\n"
+    "                         \"1e15 --threads=4\", print one result per line\n"
     "  -s, --status[=NUM]     Show computation progress 1%, 2%, 3%, ...\n"
     "                         Set digits after decimal point: -s1 prints 99.9%\n"
+    "      --table-cache-dir=DIR\n"
+    "                         Save the generated lookup tables to DIR and\n"
+    "                         reuse them in later computations\n"
     "      --test             Run various correctness tests and exit\n"
     "      --time             Print the time elapsed in seconds\n"
     "  -t, --threads=NUM      Set the number of threads, 1 <= NUM <= CPU cores.\n"
     "                         By default primecount uses all available CPU cores.\n"
     "  -v, --version          Print version and license information\n"
+    "      --worktodo=FILE    Compute the queries of FILE (one per line), save\n"
+    "                         the results to FILE.results and resume later\n"
     "  -h, --help             Print this help menu\n"
     "\n"
     "Advanced options for the Deleglise-Rivat algorithm:\n"
@@ -13,18 +13,21 @@
 #include "primecount.hpp"
 #include "primecount-internal.hpp"
 #include "gourdon.hpp"
-#include "imath.hpp"
 #include "int128_t.hpp"
-#include "PhiTiny.hpp"
 #include "print.hpp"
 #include "S.hpp"
+#include "TableCache.hpp"
 #include "to_string.hpp"
 
 #include <stdint.h>
+#include <algorithm>
 #include <exception>
+#include <iomanip>
 #include <iostream>
 #include <limits>
+#include <numeric>
 #include <string>
+#include <vector>
 
 using namespace primecount;
 
@@ -42,30 +45,16 @@ maxint_t AC(maxint_t x, int threads)
   if (x < 1)
     return 0;
 
-  auto alpha = get_alpha_gourdon(x);
-  double alpha_y = alpha.first;
-  double alpha_z = alpha.second;
+  double alpha_y = get_alpha_gourdon(x).first;
   maxint_t limit = get_max_x(alpha_y);
 
   if (x > limit)
     throw primecount_error("AC(x): x must be <= " + to_string(limit));
 
-  int64_t x13 = iroot<3>(x);
-  int64_t sqrtx = isqrt(x);
-  int64_t y = (int64_t)(x13 * alpha_y);
-
-  // x^(1/3) < y < x^(1/2)
-  y = std::max(y, x13 + 1);
-  y = std::min(y, sqrtx - 1);
-  y = std::max(y, (int64_t) 1);
-
-  int64_t k = PhiTiny::get_k(x);
-  int64_t z = (int64_t)(y * alpha_z);
-
-  // y <= z < x^(1/2)
-  z = std::max(z, y);
-  z = std::min(z, sqrtx - 1);
-  z = std::max(z, (int64_t) 1);
+  GourdonVars v = get_gourdon_vars(x);
+  int64_t y = v.y;
+  int64_t z = v.z;
+  int64_t k = v.k;
 
   if (is_print())
     set_print_variables(true);
@@ -81,21 +70,13 @@ maxint_t B(maxint_t x, int threads)
   if (x < 1)
     return 0;
 
-  auto alpha = get_alpha_gourdon(x);
-  double alpha_y = alpha.first;
+  double alpha_y = get_alpha_gourdon(x).first;
   maxint_t limit = get_max_x(alpha_y);
 
   if (x > limit)
     throw primecount_error("B(x): x must be <= " + to_string(limit));
 
-  int64_t x13 = iroot<3>(x);
-  int64_t sqrtx = isqrt(x);
-  int64_t y = (int64_t)(x13 * alpha_y);
-
-  // x^(1/3) < y < x^(1/2)
-  y = std::max(y, x13 + 1);
-  y = std::min(y, sqrtx - 1);
-  y = std::max(y, (int64_t) 1);
+  int64_t y = get_gourdon_vars(x).y;
 
   if (is_print())
     set_print_variables(true);
@@ -111,30 +92,16 @@ maxint_t D(maxint_t x, int threads)
   if (x < 1)
     return 0;
 
-  auto alpha = get_alpha_gourdon(x);
-  double alpha_y = alpha.first;
-  double alpha_z = alpha.second;
+  double alpha_y = get_alpha_gourdon(x).first;
   maxint_t limit = get_max_x(alpha_y);
 
   if (x > limit)
     throw primecount_error("D(x): x must be <= " + to_string(limit));
 
-  int64_t x13 = iroot<3>(x);
-  int64_t sqrtx = isqrt(x);
-  int64_t y = (int64_t)(x13 * alpha_y);
-
-  // x^(1/3) < y < x^(1/2)
-  y = std::max(y, x13 + 1);
-  y = std::min(y, sqrtx - 1);
-  y = std::max(y, (int64_t) 1);
-
-  int64_t k = PhiTiny::get_k(x);
-  int64_t z = (int64_t)(y * alpha_z);
-
-  // y <= z < x^(1/2)
-  z = std::max(z, y);
-  z = std::min(z, sqrtx - 1);
-  z = std::max(z, (int64_t) 1);
+  GourdonVars v = get_gourdon_vars(x);
+  int64_t y = v.y;
+  int64_t z = v.z;
+  int64_t k = v.k;
 
   if (is_print())
     set_print_variables(true);
@@ -150,30 +117,16 @@ maxint_t Phi0(maxint_t x, int threads)
   if (x < 1)
     return 0;
 
-  auto alpha = get_alpha_gourdon(x);
-  double alpha_y = alpha.first;
-  double alpha_z = alpha.second;
+  double alpha_y = get_alpha_gourdon(x).first;
   maxint_t limit = get_max_x(alpha_y);
 
   if (x > limit)
     throw primecount_error("Phi0(x): x must be <= " + to_string(limit));
 
-  int64_t x13 = iroot<3>(x);
-  int64_t sqrtx = isqrt(x);
-  int64_t y = (int64_t)(x13 * alpha_y);
-
-  // x^(1/3) < y < x^(1/2)
-  y = std::max(y, x13 + 1);
-  y = std::min(y, sqrtx - 1);
-  y = std::max(y, (int64_t) 1);
-
-  int64_t k = PhiTiny::get_k(x);
-  int64_t z = (int64_t)(y * alpha_z);
-
-  // y <= z < x^(1/2)
-  z = std::max(z, y);
-  z = std::min(z, sqrtx - 1);
-  z = std::max(z, (int64_t) 1);
+  GourdonVars v = get_gourdon_vars(x);
+  int64_t y = v.y;
+  int64_t z = v.z;
+  int64_t k = v.k;
 
   if (is_print())
     set_print_variables(true);
@@ -189,21 +142,13 @@ maxint_t Sigma(maxint_t x, int threads)
   if (x < 1)
     return 0;
 
-  auto alpha = get_alpha_gourdon(x);
-  double alpha_y = alpha.first;
+  double alpha_y = get_alpha_gourdon(x).first;
   maxint_t limit = get_max_x(alpha_y);
 
   if (x > limit)
     throw primecount_error("Sigma(x): x must be <= " + to_string(limit));
 
-  int64_t x13 = iroot<3>(x);
-  int64_t sqrtx = isqrt(x);
-  int64_t y = (int64_t)(x13 * alpha_y);
-
-  // x^(1/3) < y < x^(1/2)
-  y = std::max(y, x13 + 1);
-  y = std::min(y, sqrtx - 1);
-  y = std::max(y, (int64_t) 1);
+  int64_t y = get_gourdon_vars(x).y;
 
   if (is_print())
     set_print_variables(true);
@@ -228,7 +173,7 @@ maxint_t P2(maxint_t x, int threads)
   if (is_print())
     set_print_variables(true);
 
-  int64_t y = (int64_t) (iroot<3>(x) * alpha);
+  int64_t y = get_deleglise_rivat_vars(x).y;
   int64_t a = pi_noprint(y, threads);
 
   if (x <= std::numeric_limits<int64_t>::max())
@@ -251,8 +196,9 @@ maxint_t S1(maxint_t x, int threads)
   if (is_print())
     set_print_variables(true);
 
-  int64_t y = (int64_t) (iroot<3>(x) * alpha);
-  int64_t c = PhiTiny::get_c(y);
+  DelegliseRivatVars v = get_deleglise_rivat_vars(x);
+  int64_t y = v.y;
+  int64_t c = v.c;
 
   if (x <= std::numeric_limits<int64_t>::max())
     return S1((int64_t) x, y, c, threads);
@@ -274,9 +220,10 @@ maxint_t S2_trivial(maxint_t x, int threads)
   if (is_print())
     set_print_variables(true);
 
-  int64_t y = (int64_t) (iroot<3>(x) * alpha);
-  int64_t z = (int64_t) (x / y);
-  int64_t c = PhiTiny::get_c(y);
+  DelegliseRivatVars v = get_deleglise_rivat_vars(x);
+  int64_t y = v.y;
+  int64_t z = v.z;
+  int64_t c = v.c;
 
   if (x <= std::numeric_limits<int64_t>::max())
     return S2_trivial((int64_t) x, y, z, c, threads);
@@ -298,9 +245,10 @@ maxint_t S2_easy(maxint_t x, int threads)
   if (is_print())
     set_print_variables(true);
 
-  int64_t y = (int64_t) (iroot<3>(x) * alpha);
-  int64_t z = (int64_t) (x / y);
-  int64_t c = PhiTiny::get_c(y);
+  DelegliseRivatVars v = get_deleglise_rivat_vars(x);
+  int64_t y = v.y;
+  int64_t z = v.z;
+  int64_t c = v.c;
 
   if (x <= std::numeric_limits<int64_t>::max())
     return S2_easy((int64_t) x, y, z, c, threads);
@@ -322,9 +270,10 @@ maxint_t S2_hard(maxint_t x, int threads)
   if (is_print())
     set_print_variables(true);
 
-  int64_t y = (int64_t) (iroot<3>(x) * alpha);
-  int64_t z = (int64_t) (x / y);
-  int64_t c = PhiTiny::get_c(y);
+  DelegliseRivatVars v = get_deleglise_rivat_vars(x);
+  int64_t y = v.y;
+  int64_t z = v.z;
+  int64_t c = v.c;
 
   if (x <= std::numeric_limits<int64_t>::max())
     return S2_hard((int64_t) x, y, z, c, (int64_t) Li(x), threads);
@@ -332,6 +281,201 @@ maxint_t S2_hard(maxint_t x, int threads)
     return S2_hard(x, y, z, c, Li(x), threads);
 }
 
+/// Compute the function selected by the command-line
+/// options e.g. pi(x), nth_prime(x), phi(x, a), ...
+///
+maxint_t compute(const CmdOptions& opt, int threads)
+{
+  auto x = opt.x;
+  auto a = opt.a;
+  maxint_t res = 0;
+
+  switch (opt.option)
+  {
+    case OPTION_DEFAULT:
+      res = pi(x, threads); break;
+    case OPTION_DELEGLISE_RIVAT:
+      res = pi_deleglise_rivat(x, threads); break;
+    case OPTION_DELEGLISE_RIVAT_64:
+      res = pi_deleglise_rivat_64(to_int64(x), threads); break;
+    case OPTION_GOURDON:
+      res = pi_gourdon(x, threads); break;
+    case OPTION_GOURDON_64:
+      res = pi_gourdon_64(to_int64(x), threads); break;
+    case OPTION_LEGENDRE:
+      res = pi_legendre(to_int64(x), threads); break;
+    case OPTION_LEHMER:
+      res = pi_lehmer(to_int64(x), threads); break;
+    case OPTION_LMO:
+      res = pi_lmo_parallel(to_int64(x), threads); break;
+    case OPTION_LMO1:
+      res = pi_lmo1(to_int64(x)); break;
+    case OPTION_LMO2:
+      res = pi_lmo2(to_int64(x)); break;
+    case OPTION_LMO3:
+      res = pi_lmo3(to_int64(x)); break;
+    case OPTION_LMO4:
+      res = pi_lmo4(to_int64(x)); break;
+    case OPTION_LMO5:
+      res = pi_lmo5(to_int64(x)); break;
+    case OPTION_MEISSEL:
+      res = pi_meissel(to_int64(x), threads); break;
+    case OPTION_PRIMESIEVE:
+      res = pi_primesieve(to_int64(x)); break;
+    case OPTION_LI:
+      res = Li(x); break;
+    case OPTION_LIINV:
+      res = Li_inverse(x); break;
+    case OPTION_RI:
+      res = Ri(x); break;
+    case OPTION_RIINV:
+      res = Ri_inverse(x); break;
+    case OPTION_NTHPRIME:
+      res = nth_prime(x, threads); break;
+    case OPTION_PHI:
+      res = phi(to_int64(x), a, threads); break;
+    case OPTION_P2:
+      res = P2(x, threads); break;
+    case OPTION_S1:
+      res = S1(x, threads); break;
+    case OPTION_S2_EASY:
+      res = S2_easy(x, threads); break;
+    case OPTION_S2_HARD:
+      res = S2_hard(x, threads); break;
+    case OPTION_S2_TRIVIAL:
+      res = S2_trivial(x, threads); break;
+    case OPTION_AC:
+      res = AC(x, threads); break;
+    case OPTION_B:
+      res = B(x, threads); break;
+    case OPTION_D:
+      res = D(x, threads); break;
+    case OPTION_PHI0:
+      res = Phi0(x, threads); break;
+    case OPTION_SIGMA:
+      res = Sigma(x, threads); break;
+#ifdef HAVE_INT128_T
+    case OPTION_DELEGLISE_RIVAT_128:
+      res = pi_deleglise_rivat_128(x, threads); break;
+    case OPTION_GOURDON_128:
+      res = pi_gourdon_128(x, threads); break;
+#endif
+  }
+
+  return res;
+}
+
+/// In --server mode primecount reads queries from stdin,
+/// one query per line, and prints one result per line. A
+/// query uses the same syntax as the command-line options
+/// e.g. "1e15 --threads=4" or "--phi 1000 10". The memory
+/// table cache is enabled while the server runs, hence the
+/// lookup tables (and the threads) are reused by all queries,
+/// this avoids the process start-up and table initialization
+/// overhead of running primecount thousands of times.
+///
+void server()
+{
+  std::string query;
+  set_memory_table_cache(true);
+
+  while (std::getline(std::cin, query))
+  {
+    // Ignore empty lines
+    if (query.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+
+    try
+    {
+      CmdOptions opt = parseQuery(query);
+
+      // The status would be mixed with the results
+      if (opt.status)
+        throw primecount_error("option '--status' not supported in --server mode");
+
+      ConfigGuard guard(opt.config);
+      double time = get_time();
+      int threads = config_threads(opt.config);
+      maxint_t res = compute(opt, threads);
+      std::cout << res;
+
+      if (opt.time)
+        std::cout << " " << std::fixed << std::setprecision(3) << get_time() - time;
+
+      std::cout << std::endl;
+    }
+    catch (std::exception& e)
+    {
+      std::cout << "error: " << e.what() << std::endl;
+    }
+  }
+
+  set_memory_table_cache(false);
+}
+
+/// Compute multiple numbers e.g. primecount 1e20 2e20 3e20.
+/// The numbers are computed in decreasing order and each
+/// distinct number is computed only once. The memory table
+/// cache is enabled, hence the large lookup tables (>= 10^7
+/// entries) of the largest number are
+/// reused by the smaller numbers, a PiTable or FactorTable
+/// can be used by all numbers <= its limit. FactorTableD
+/// depends on y and is only reused for the same y. Other
+/// work (e.g. the sieving primes) is not shared. The
+/// results are printed in input order.
+///
+void batch(CmdOptions opt)
+{
+  std::size_t n = opt.numbers.size();
+  std::vector<std::size_t> order(n);
+  std::vector<maxint_t> results(n);
+  std::vector<bool> done(n, false);
+  std::iota(order.begin(), order.end(), 0);
+
+  std::stable_sort(order.begin(), order.end(),
+    [&](std::size_t i, std::size_t j) {
+      return opt.numbers[i] > opt.numbers[j];
+  });
+
+  int threads = get_num_threads();
+  std::size_t next = 0;
+  std::size_t prev = n;
+  set_memory_table_cache(true);
+
+  for (std::size_t i : order)
+  {
+    // Identical numbers are adjacent after sorting
+    if (prev < n && opt.numbers[prev] == opt.numbers[i])
+      results[i] = results[prev];
+    else
+    {
+      opt.x = opt.numbers[i];
+      results[i] = compute(opt, threads);
+    }
+
+    done[i] = true;
+    prev = i;
+
+    // Print the results as soon as possible
+    for (; next < n && done[next]; next++)
+      std::cout << results[next] << std::endl;
+  }
+
+  set_memory_table_cache(false);
+}
+
+/// primecount --grid=x0:step:count prints x <tab> pi(x)
+/// for x = x0 + i * step with 0 <= i < count. Each line
+/// is printed as soon as pi(x) has been computed.
+///
+void grid(const CmdOptions& opt)
+{
+  pi_grid(opt.x, opt.step, opt.count, get_num_threads(),
+    [](maxint_t x, maxint_t pix) {
+      std::cout << x << '\t' << pix << std::endl;
+  });
+}
+
 } // namespace
 
 int main (int argc, char* argv[])
@@ -339,85 +483,40 @@ int main (int argc, char* argv[])
   try
   {
     CmdOptions opt = parseOptions(argc, argv);
+
+    if (opt.server)
+    {
+      server();
+      return 0;
+    }
+
+    if (!opt.worktodo.empty())
+    {
+      worktodo(opt);
+      return 0;
+    }
+
     double time = get_time();
 
-    auto x = opt.x;
-    auto a = opt.a;
-    auto threads = get_num_threads();
-    maxint_t res = 0;
+    if (opt.grid)
+    {
+      grid(opt);
+      if (opt.time)
+        print_seconds(get_time() - time);
+      return 0;
+    }
 
-    switch (opt.option)
+    if (opt.numbers.size() > 1 &&
+        opt.option != OPTION_PHI)
     {
-      case OPTION_DEFAULT:
-        res = pi(x, threads); break;
-      case OPTION_DELEGLISE_RIVAT:
-        res = pi_deleglise_rivat(x, threads); break;
-      case OPTION_DELEGLISE_RIVAT_64:
-        res = pi_deleglise_rivat_64(to_int64(x), threads); break;
-      case OPTION_GOURDON:
-        res = pi_gourdon(x, threads); break;
-      case OPTION_GOURDON_64:
-        res = pi_gourdon_64(to_int64(x), threads); break;
-      case OPTION_LEGENDRE:
-        res = pi_legendre(to_int64(x), threads); break;
-      case OPTION_LEHMER:
-        res = pi_lehmer(to_int64(x), threads); break;
-      case OPTION_LMO:
-        res = pi_lmo_parallel(to_int64(x), threads); break;
-      case OPTION_LMO1:
-        res = pi_lmo1(to_int64(x)); break;
-      case OPTION_LMO2:
-        res = pi_lmo2(to_int64(x)); break;
-      case OPTION_LMO3:
-        res = pi_lmo3(to_int64(x)); break;
-      case OPTION_LMO4:
-        res = pi_lmo4(to_int64(x)); break;
-      case OPTION_LMO5:
-        res = pi_lmo5(to_int64(x)); break;
-      case OPTION_MEISSEL:
-        res = pi_meissel(to_int64(x), threads); break;
-      case OPTION_PRIMESIEVE:
-        res = pi_primesieve(to_int64(x)); break;
-      case OPTION_LI:
-        res = Li(x); break;
-      case OPTION_LIINV:
-        res = Li_inverse(x); break;
-      case OPTION_RI:
-        res = Ri(x); break;
-      case OPTION_RIINV:
-        res = Ri_inverse(x); break;
-      case OPTION_NTHPRIME:
-        res = nth_prime(to_int64(x), threads); break;
-      case OPTION_PHI:
-        res = phi(to_int64(x), a, threads); break;
-      case OPTION_P2:
-        res = P2(x, threads); break;
-      case OPTION_S1:
-        res = S1(x, threads); break;
-      case OPTION_S2_EASY:
-        res = S2_easy(x, threads); break;
-      case OPTION_S2_HARD:
-        res = S2_hard(x, threads); break;
-      case OPTION_S2_TRIVIAL:
-        res = S2_trivial(x, threads); break;
-      case OPTION_AC:
-        res = AC(x, threads); break;
-      case OPTION_B:
-        res = B(x, threads); break;
-      case OPTION_D:
-        res = D(x, threads); break;
-      case OPTION_PHI0:
-        res = Phi0(x, threads); break;
-      case OPTION_SIGMA:
-        res = Sigma(x, threads); break;
-#ifdef HAVE_INT128_T
-      case OPTION_DELEGLISE_RIVAT_128:
-        res = pi_deleglise_rivat_128(x, threads); break;
-      case OPTION_GOURDON_128:
-        res = pi_gourdon_128(x, threads); break;
-#endif
+      batch(opt);
+      if (opt.time)
+        print_seconds(get_time() - time);
+      return 0;
     }
 
+    maxint_t res = compute(opt, get_num_threads());
+
     if (is_print_combined_result())
     {
       // Add empty line after last partial formula
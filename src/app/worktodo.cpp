@@ -0,0 +1,278 @@
+///
+/// @file   worktodo.cpp
+/// @brief  Process the computations of a worktodo file, one query
+///         per line using the same syntax as the command-line
+///         options e.g. "1e23 --threads=64". Empty lines and
+///         lines starting with # are ignored. Each finished
+///         computation is appended to the results file and then
+///         removed from the worktodo file, hence an interrupted
+///         run resumes with the unfinished computations. Lines
+///         whose computation failed are kept in the worktodo file.
+///
+///         If there are both small and large computations, the
+///         small computations run concurrently on a single
+///         thread while the large computations use the
+///         remaining threads.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "cmdoptions.hpp"
+
+#include "primecount.hpp"
+#include "primecount-internal.hpp"
+#include "int128_t.hpp"
+#include "print.hpp"
+#include "to_string.hpp"
+
+#include <stdint.h>
+#include <atomic>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace primecount;
+
+namespace {
+
+/// Computations with x <= small_x take less than
+/// about 1 second using a single thread.
+const maxint_t small_x = (maxint_t) 1e13;
+
+struct Line
+{
+  std::string str;
+  CmdOptions opt;
+  std::string error;
+  bool is_query = false;
+  bool done = false;
+};
+
+class WorkTodo
+{
+public:
+  WorkTodo(const CmdOptions& opts);
+  void run(int threads);
+
+private:
+  void process(Line& line, int threads);
+  void save();
+
+  std::string filename_;
+  std::string results_;
+  std::vector<Line> lines_;
+  std::mutex mutex_;
+  // Command-line --status setting
+  bool status_;
+  int status_precision_;
+};
+
+WorkTodo::WorkTodo(const CmdOptions& opts) :
+  filename_(opts.worktodo),
+  results_(opts.worktodo + ".results"),
+  status_(opts.status),
+  status_precision_(opts.status_precision)
+{
+  std::ifstream file(filename_);
+  if (!file)
+    throw primecount_error("failed to open worktodo file: " + filename_);
+
+  for (std::string str; std::getline(file, str);)
+  {
+    Line line;
+    line.str = str;
+    std::size_t pos = str.find_first_not_of(" \t\r");
+
+    // Skip empty lines and comments
+    if (pos != std::string::npos && str[pos] != '#')
+    {
+      line.is_query = true;
+      try {
+        line.opt = parseQuery(str);
+      }
+      catch (std::exception& e) {
+        line.error = e.what();
+      }
+    }
+
+    lines_.push_back(line);
+  }
+}
+
+void WorkTodo::run(int threads)
+{
+  std::vector<Line*> small;
+  std::vector<Line*> large;
+  bool status = status_;
+
+  for (Line& line : lines_)
+  {
+    if (line.is_query)
+    {
+      status |= line.opt.status;
+      if (line.error.empty() && line.opt.x > small_x)
+        large.push_back(&line);
+      else
+        small.push_back(&line);
+    }
+  }
+
+  // When printing the status only 1 computation
+  // may run at a time. Otherwise the small
+  // computations run concurrently on 1 thread.
+  if (threads < 2 ||
+      status ||
+      small.empty() ||
+      large.empty())
+  {
+    for (Line& line : lines_)
+      if (line.is_query)
+        process(line, threads);
+
+    return;
+  }
+
+  std::atomic<bool> small_done(false);
+  std::exception_ptr error;
+
+  std::thread worker([&] {
+    try {
+      for (Line* line : small)
+        process(*line, 1);
+    }
+    catch (...) {
+      error = std::current_exception();
+    }
+    small_done = true;
+  });
+
+  try
+  {
+    // Once the small computations have finished
+    // the large computations use all threads.
+    for (Line* line : large)
+      process(*line, small_done ? threads : threads - 1);
+  }
+  catch (...)
+  {
+    worker.join();
+    throw;
+  }
+
+  worker.join();
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+/// Compute the query of the line, append the result to the
+/// results file and remove the line from the worktodo file.
+/// If the computation fails the error is appended to the
+/// results file but the line is kept in the worktodo file.
+/// Result format: query <tab> result <tab> seconds
+///
+void WorkTodo::process(Line& line, int threads)
+{
+  double time = get_time();
+  std::string result;
+  bool ok = false;
+
+  if (!line.error.empty())
+    result = "error: " + line.error;
+  else
+  {
+    // Per line -s, --status[=NUM]
+    if (line.opt.status)
+    {
+      set_print(true);
+      set_status_precision(line.opt.status_precision);
+    }
+
+    try
+    {
+      ConfigGuard guard(line.opt.config);
+      if (line.opt.config.threads > 0)
+        threads = config_threads(line.opt.config);
+      result = to_string(compute(line.opt, threads));
+      ok = true;
+    }
+    catch (std::exception& e)
+    {
+      result = std::string("error: ") + e.what();
+    }
+
+    if (line.opt.status)
+    {
+      set_print(status_);
+      set_status_precision(status_precision_);
+    }
+  }
+
+  std::ostringstream oss;
+  oss << line.str << '\t' << result << '\t'
+      << std::fixed << std::setprecision(3) << get_time() - time;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ofstream results(results_, std::ios::app);
+  results << oss.str() << std::endl;
+
+  if (!results)
+    throw primecount_error("failed to write results file: " + results_);
+
+  std::cout << oss.str() << std::endl;
+
+  if (ok)
+  {
+    line.done = true;
+    save();
+  }
+}
+
+/// Write the unfinished lines to a temporary file
+/// which is then renamed, this way the worktodo file
+/// is never left partially written.
+///
+void WorkTodo::save()
+{
+  std::string tmp = filename_ + ".tmp";
+
+  {
+    std::ofstream file(tmp);
+    for (const Line& line : lines_)
+      if (!line.done)
+        file << line.str << '\n';
+
+    if (!file)
+      throw primecount_error("failed to write worktodo file: " + tmp);
+  }
+
+  if (std::rename(tmp.c_str(), filename_.c_str()) != 0)
+  {
+    // On Windows rename() fails if the file exists
+    std::remove(filename_.c_str());
+    if (std::rename(tmp.c_str(), filename_.c_str()) != 0)
+      throw primecount_error("failed to write worktodo file: " + filename_);
+  }
+}
+
+} // namespace
+
+namespace primecount {
+
+void worktodo(const CmdOptions& opts)
+{
+  WorkTodo work(opts);
+  work.run(get_num_threads());
+}
+
+} // namespace
@@ -0,0 +1,339 @@
+///
+/// @file  count_primes.cpp
+/// @brief Count the primes inside [a, b]. If b - a is small
+///        the primes are counted using a segmented sieve of
+///        Eratosthenes which runs in O(b - a + sqrt(b)) (above
+///        2^64 the sqrt(b) term is paid once per segment), else
+///        we compute pi(b) - pi(a - 1) using the prime counting
+///        function which runs in O(b^(2/3) / (log b)^2).
+///
+///        pi_grid() computes pi(x0 + i * step) for many i: pi(x0)
+///        is computed once using the prime counting function and
+///        then the grid is swept using a parallel segmented sieve
+///        of Eratosthenes. For large steps it is cheaper to
+///        compute pi(x) of each grid point individually.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "primecount.hpp"
+#include "primecount-internal.hpp"
+#include "IntervalSieve.hpp"
+#include "primesieve.hpp"
+#include "parallel.hpp"
+#include "int128_t.hpp"
+#include "imath.hpp"
+#include "isqrt.hpp"
+#include "min.hpp"
+#include "to_string.hpp"
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace primecount;
+
+namespace {
+
+/// Estimated run time of pi(x) using Gourdon's algorithm, in units
+/// of the time needed to sieve 1 integer < 10^10. Calibrated
+/// using pi_gourdon_64() and primesieve::count_primes() for
+/// 10^10 <= x <= 10^18, for smaller x pi(x) runs in a few
+/// milliseconds.
+///
+double pi_cost(double x)
+{
+  if (x < 1e5)
+    return 0;
+
+  double logx = std::log(x);
+  return 1500 * std::pow(x, 2.0 / 3.0) / (logx * logx);
+}
+
+/// Estimated run time of sieving [a, b], the sieve of
+/// Eratosthenes gets slower for larger numbers as the
+/// sieving primes <= sqrt(b) do not fit into the CPU's
+/// cache anymore. primesieve generates the sieving primes
+/// only once, but the IntervalSieve (used for numbers
+/// > 2^64) generates them once per segment of
+/// threads * IntervalSieve::max_segment_size() integers.
+///
+double sieve_cost(double a, double b, int threads)
+{
+  double log_ratio = std::log(std::max(b, 1e10)) / std::log(1e10);
+  double sqrt_cost = std::sqrt(b);
+  double max_stop = (double) primesieve::get_max_stop();
+
+  if (b > max_stop)
+  {
+    double max_segment = (double) IntervalSieve::max_segment_size() * std::max(threads, 1);
+    double segments = std::ceil((b - std::max(a, max_stop)) / max_segment);
+    sqrt_cost *= std::max(segments, 1.0);
+  }
+
+  return (b - a + sqrt_cost) * log_ratio * log_ratio;
+}
+
+/// Count the primes inside ]x + i * step, x + (i + 1) * step]
+/// for 0 <= i < counts.size(). Each thread sieves a contiguous
+/// range of grid intervals using a primesieve::iterator,
+/// hence the sieving primes <= sqrt(high) are generated only
+/// once per thread. The primes are counted per buffer of
+/// primes (like in P2.cpp) instead of one by one.
+/// @pre x + counts.size() * step <= primesieve::get_max_stop()
+///
+void sieve_grid(maxint_t x,
+                maxint_t step,
+                std::vector<maxint_t>& counts,
+                int64_t thread_dist,
+                int threads)
+{
+  int64_t n = (int64_t) counts.size();
+  maxint_t dist = n * step;
+  threads = ideal_num_threads((int64_t) dist, threads, thread_dist);
+  threads = (int) std::min((int64_t) threads, n);
+
+  parallel_region(threads, [&](int t)
+  {
+    int64_t begin = n * t / threads;
+    int64_t end = n * (t + 1) / threads;
+    maxint_t low = max(x + begin * step + 1, 0);
+    maxint_t high = x + end * step;
+
+    if (high < 2)
+      return;
+
+    primesieve::iterator it((uint64_t) low, (uint64_t) high);
+    it.generate_next_primes();
+
+    for (int64_t i = begin; i < end; i++)
+    {
+      // primesieve::iterator cannot generate primes > 2^64,
+      // 18446744073709551557 is the largest prime < 2^64.
+      uint64_t stop = (uint64_t) (x + (i + 1) * step);
+      stop = std::min(stop, (uint64_t) 18446744073709551557ull);
+      uint64_t count = 0;
+
+      for (; it.primes_[it.size_ - 1] < stop; it.generate_next_primes())
+        count += it.size_ - it.i_;
+      for (; it.i_ < it.size_ && it.primes_[it.i_] <= stop; it.i_++)
+        count += 1;
+
+      counts[i] = count;
+    }
+  });
+}
+
+/// Sweep the grid intervals ]x + i * step, x + (i + 1) * step]
+/// for 0 <= i < n segment by segment using the IntervalSieve
+/// and pass pi(x + (i + 1) * step) to the callback. Each
+/// segment contains many grid intervals, hence the sieving
+/// primes <= sqrt(high) are generated once per segment
+/// instead of once per grid interval.
+/// @pre x >= primesieve::get_max_stop()
+///
+void sweep_grid(maxint_t x,
+                maxint_t step,
+                int64_t n,
+                maxint_t pix,
+                int threads,
+                const std::function<void(maxint_t, maxint_t)>& callback)
+{
+  IntervalSieve sieve(threads);
+  maxint_t max_segment = sieve.segment_size();
+  maxint_t high = x + n * step;
+  maxint_t low = x + 1;
+  maxint_t next = x + step;
+
+  while (low <= high)
+  {
+    check_cancelled();
+    maxint_t stop = high;
+    if (high - low >= max_segment)
+      stop = low + (max_segment - 1);
+
+    sieve.sieve((maxuint_t) low, (maxuint_t) stop);
+
+    for (; next <= stop; next += step)
+    {
+      pix += sieve.count((maxuint_t) low, (maxuint_t) next);
+      callback(next, pix);
+      low = next + 1;
+    }
+
+    pix += sieve.count((maxuint_t) low, (maxuint_t) stop);
+    low = stop + 1;
+  }
+}
+
+} // namespace
+
+namespace primecount {
+
+maxint_t count_primes(maxint_t a, maxint_t b, int threads)
+{
+  if (a < 0)
+    a = 0;
+  if (b < a || b < 2)
+    return 0;
+
+  double sieve = sieve_cost((double) a, (double) b, threads);
+  double pi_ab = pi_cost((double) b) + pi_cost((double) (a - 1));
+
+  if (sieve <= pi_ab)
+  {
+    if (b > to_maxint(get_max_x()))
+      throw primecount_error("count_primes(a, b): b must be <= " + get_max_x());
+
+    return (maxint_t) count_primes_sieve((maxuint_t) a, (maxuint_t) b, threads);
+  }
+
+  if (a <= 2)
+    return pi(b, threads);
+  else
+    return pi(b, threads) - pi(a - 1, threads);
+}
+
+int64_t count_primes(int64_t a, int64_t b)
+{
+  return (int64_t) count_primes((maxint_t) a, (maxint_t) b, get_num_threads());
+}
+
+std::string count_primes(const std::string& a, const std::string& b)
+{
+  maxint_t res = count_primes(to_maxint(a), to_maxint(b), get_num_threads());
+  return to_string(res);
+}
+
+/// The grid points are processed in batches, the grid
+/// intervals of a batch are sieved in parallel and then
+/// the results of the batch are passed to the callback in
+/// increasing order. Hence the memory usage is bounded by
+/// the batch size and not by the number of grid points.
+///
+void pi_grid(maxint_t x0,
+             maxint_t step,
+             int64_t count,
+             int threads,
+             const std::function<void(maxint_t, maxint_t)>& callback)
+{
+  if (count <= 0)
+    return;
+  if (step < 1)
+    throw primecount_error("pi_grid: step must be >= 1");
+
+  maxint_t max_x = to_maxint(get_max_x());
+  if (x0 > max_x ||
+      (max_x - x0) / step < count - 1)
+    throw primecount_error("pi_grid: x0 + (count - 1) * step must be <= " + get_max_x());
+
+  // At most 2^16 counts per batch
+  const int64_t max_batch = 1 << 16;
+  uint64_t max_stop = primesieve::get_max_stop();
+  std::vector<maxint_t> counts;
+
+  maxint_t x = x0;
+  maxint_t pix = pi(x, threads);
+  callback(x, pix);
+
+  for (int64_t i = 1; i < count;)
+  {
+    check_cancelled();
+    maxint_t next = x + step;
+
+    // Compute pi(next) using the prime counting function
+    if (sieve_cost((double) x, (double) next, threads) > pi_cost((double) next))
+    {
+      x = next;
+      pix = pi(x, threads);
+      callback(x, pix);
+      i++;
+      continue;
+    }
+
+    // Since pi_cost() grows faster than sieve_cost(), all
+    // remaining grid points are sieved. primesieve does not
+    // support numbers > 2^64, these are swept using the
+    // IntervalSieve.
+    if (x >= max_stop)
+    {
+      sweep_grid(x, step, count - i, pix, threads, callback);
+      return;
+    }
+
+    // Each thread sieves a distance of at least 4 * sqrt(x)
+    // so that generating the sieving primes is cheap
+    // compared to sieving.
+    maxint_t high = x + (count - i) * step;
+    int64_t thread_dist = (int64_t) max(isqrt(high) * 4, (maxint_t) 1e8);
+    maxint_t batch_dist = (maxint_t) thread_dist * threads;
+    int64_t batch = (int64_t) min(ceil_div(batch_dist, step), count - i);
+    batch = std::min(batch, max_batch);
+
+    // The batch ends at 2^64, the grid interval
+    // that contains 2^64 is sieved on its own.
+    if (x + batch * step > max_stop)
+      batch = (int64_t) max((max_stop - x) / step, 1);
+
+    // Small grid intervals are distributed among the
+    // threads, large grid intervals (and the grid interval
+    // that contains 2^64) are sieved one by one using all
+    // threads.
+    high = x + batch * step;
+
+    if (step < thread_dist &&
+        high <= max_stop)
+    {
+      counts.resize(batch);
+      sieve_grid(x, step, counts, thread_dist, threads);
+
+      for (maxint_t n : counts)
+      {
+        x += step;
+        pix += n;
+        callback(x, pix);
+      }
+    }
+    else
+    {
+      for (int64_t j = 0; j < batch; j++)
+      {
+        pix += (maxint_t) count_primes_sieve((maxuint_t) (x + 1), (maxuint_t) (x + step), threads);
+        x += step;
+        callback(x, pix);
+      }
+    }
+
+    i += batch;
+  }
+}
+
+void pi_grid(int64_t x0,
+             int64_t step,
+             int64_t count,
+             const std::function<void(int64_t, int64_t)>& callback)
+{
+  pi_grid(x0, step, count, get_num_threads(),
+    [&](maxint_t x, maxint_t pix) {
+      callback((int64_t) x, (int64_t) pix);
+  });
+}
+
+void pi_grid(const std::string& x0,
+             const std::string& step,
+             int64_t count,
+             const std::function<void(const std::string&, const std::string&)>& callback)
+{
+  pi_grid(to_maxint(x0), to_maxint(step), count, get_num_threads(),
+    [&](maxint_t x, maxint_t pix) {
+      callback(to_string(x), to_string(pix));
+  });
+}
+
+} // namespace
@@ -23,7 +23,8 @@
 #include "min.hpp"
 #include "imath.hpp"
 #include "print.hpp"
-#include "RelaxedAtomic.hpp"
+#include "TaskScheduler.hpp"
+#include "parallel.hpp"
 #include "StatusS2.hpp"
 #include "S.hpp"
 
@@ -61,56 +62,75 @@ T S2_easy_OpenMP(T x,
   PiTable pi(y, threads);
   int64_t pi_sqrty = pi[isqrt(y)];
   int64_t pi_x13 = pi[x13];
-  RelaxedAtomic<int64_t> min_b(max(c, pi_sqrty) + 1);
+  TaskScheduler scheduler;
 
   // for (b = pi[sqrty] + 1; b <= pi_x13; b++)
-  #pragma omp parallel num_threads(threads) reduction(+: sum)
-  for (int64_t b = min_b++; b <= pi_x13; b = min_b++)
+  // The inner loop iterates over the easy leaves
+  // pi_min_sparse < l <= pi[min_trivial].
+  for (int64_t b = max(c, pi_sqrty) + 1; b <= pi_x13; b++)
   {
     int64_t prime = primes[b];
     T xp = x / prime;
     int64_t min_trivial = min(xp / prime, y);
-    int64_t min_clustered = (int64_t) isqrt(xp);
-    int64_t min_sparse = z / prime;
-
-    min_clustered = in_between(prime, min_clustered, y);
-    min_sparse = in_between(prime, min_sparse, y);
-
-    int64_t l = pi[min_trivial];
-    int64_t pi_min_clustered = pi[min_clustered];
-    int64_t pi_min_sparse = pi[min_sparse];
-
-    // Find all clustered easy leaves where
-    // successive leaves are identical.
-    // pq = primes[b] * primes[l]
-    // Which satisfy: pq > z && x / pq <= y
-    // where phi(x / pq, b - 1) = pi(x / pq) - b + 2
-    while (l > pi_min_clustered)
-    {
-      int64_t xpq = fast_div64(xp, primes[l]);
-      int64_t pi_xpq = pi[xpq];
-      int64_t phi_xpq = pi_xpq - b + 2;
-      int64_t xpq2 = fast_div64(xp, primes[pi_xpq + 1]);
-      int64_t lmin = pi[xpq2];
-      sum += phi_xpq * (l - lmin);
-      l = lmin;
-    }
+    int64_t min_sparse = in_between(prime, z / prime, y);
+    int64_t start = pi[min_sparse] + 1;
+    int64_t stop = pi[min_trivial] + 1;
+    scheduler.add(b, start, stop, (double) (stop - start));
+  }
+
+  scheduler.split(threads);
 
-    // Find all sparse easy leaves where
-    // successive leaves are different.
-    // pq = primes[b] * primes[l]
-    // Which satisfy: pq > z && x / pq <= y
-    // where phi(x / pq, b - 1) = pi(x / pq) - b + 2
-    for (; l > pi_min_sparse; l--)
+  sum += parallel_sum<T>(threads, [&](int thread_num)
+  {
+    T sum = 0;
+
+    for (Task task; scheduler.get_task(task);)
     {
-      int64_t xpq = fast_div64(xp, primes[l]);
-      sum += pi[xpq] - b + 2;
+      int64_t b = task.b;
+      int64_t prime = primes[b];
+      T xp = x / prime;
+      int64_t min_clustered = (int64_t) isqrt(xp);
+      min_clustered = in_between(prime, min_clustered, y);
+
+      // This task processes the leaves min_l < l <= max_l
+      int64_t l = task.stop - 1;
+      int64_t min_l = task.start - 1;
+      int64_t pi_min_clustered = max(pi[min_clustered], min_l);
+
+      // Find all clustered easy leaves where
+      // successive leaves are identical.
+      // pq = primes[b] * primes[l]
+      // Which satisfy: pq > z && x / pq <= y
+      // where phi(x / pq, b - 1) = pi(x / pq) - b + 2
+      while (l > pi_min_clustered)
+      {
+        int64_t xpq = fast_div64(xp, primes[l]);
+        int64_t pi_xpq = pi[xpq];
+        int64_t phi_xpq = pi_xpq - b + 2;
+        int64_t xpq2 = fast_div64(xp, primes[pi_xpq + 1]);
+        int64_t lmin = max(pi[xpq2], min_l);
+        sum += phi_xpq * (l - lmin);
+        l = lmin;
+      }
+
+      // Find all sparse easy leaves where
+      // successive leaves are different.
+      // pq = primes[b] * primes[l]
+      // Which satisfy: pq > z && x / pq <= y
+      // where phi(x / pq, b - 1) = pi(x / pq) - b + 2
+      for (; l > min_l; l--)
+      {
+        int64_t xpq = fast_div64(xp, primes[l]);
+        sum += pi[xpq] - b + 2;
+      }
+
+      if (is_print &&
+          thread_num == 0)
+        status.print(b, pi_x13);
     }
 
-    #pragma omp master
-    if (is_print)
-      status.print(b, pi_x13);
-  }
+    return sum;
+  });
 
   return sum;
 }
@@ -22,13 +22,15 @@
 #include "PiTable.hpp"
 #include "primecount-internal.hpp"
 #include "fast_div.hpp"
+#include "Divider128.hpp"
 #include "generate.hpp"
 #include "int128_t.hpp"
 #include "min.hpp"
 #include "imath.hpp"
 #include "pod_vector.hpp"
 #include "print.hpp"
-#include "RelaxedAtomic.hpp"
+#include "TaskScheduler.hpp"
+#include "parallel.hpp"
 #include "StatusS2.hpp"
 #include "S.hpp"
 
@@ -45,21 +47,20 @@ template <typename T,
           typename LibdividePrimes>
 T S2_easy_64(T xp128,
              uint64_t y,
-             uint64_t z,
              uint64_t b,
              uint64_t prime,
+             const Task& task,
              const LibdividePrimes& primes,
              const PiTable& pi)
 {
   uint64_t xp = (uint64_t) xp128;
-  uint64_t min_trivial = min(xp / prime, y);
   uint64_t min_clustered = isqrt(xp);
-  uint64_t min_sparse = z / prime;
   min_clustered = in_between(prime, min_clustered, y);
-  min_sparse = in_between(prime, min_sparse, y);
-  uint64_t l = pi[min_trivial];
-  uint64_t pi_min_clustered = pi[min_clustered];
-  uint64_t pi_min_sparse = pi[min_sparse];
+
+  // This task processes the leaves min_l < l <= max_l
+  uint64_t l = task.stop - 1;
+  uint64_t min_l = task.start - 1;
+  uint64_t pi_min_clustered = max(pi[min_clustered], min_l);
 
   T sum = 0;
 
@@ -74,7 +75,7 @@ T S2_easy_64(T xp128,
     uint64_t pi_xpq = pi[xpq];
     uint64_t phi_xpq = pi_xpq - b + 2;
     uint64_t xpq2 = xp / primes[pi_xpq + 1];
-    uint64_t lmin = pi[xpq2];
+    uint64_t lmin = max(pi[xpq2], min_l);
     sum += phi_xpq * (l - lmin);
     l = lmin;
   }
@@ -84,7 +85,7 @@ T S2_easy_64(T xp128,
   // pq = primes[b] * primes[l]
   // Which satisfy: pq > z && x / pq <= y
   // where phi(x / pq, b - 1) = pi(x / pq) - b + 2
-  for (; l > pi_min_sparse; l--)
+  for (; l > min_l; l--)
   {
     uint64_t xpq = xp / primes[l];
     sum += pi[xpq] - b + 2;
@@ -95,23 +96,22 @@ T S2_easy_64(T xp128,
 
 /// xp >= 2^64
 template <typename T,
-          typename Primes>
+          typename DividerPrimes>
 T S2_easy_128(T xp,
               uint64_t y,
-              uint64_t z,
               uint64_t b,
               uint64_t prime,
-              const Primes& primes,
+              const Task& task,
+              const DividerPrimes& primes,
               const PiTable& pi)
 {
-  uint64_t min_trivial = min(xp / prime, y);
   uint64_t min_clustered = (uint64_t) isqrt(xp);
-  uint64_t min_sparse = z / prime;
   min_clustered = in_between(prime, min_clustered, y);
-  min_sparse = in_between(prime, min_sparse, y);
-  uint64_t l = pi[min_trivial];
-  uint64_t pi_min_clustered = pi[min_clustered];
-  uint64_t pi_min_sparse = pi[min_sparse];
+
+  // This task processes the leaves min_l < l <= max_l
+  uint64_t l = task.stop - 1;
+  uint64_t min_l = task.start - 1;
+  uint64_t pi_min_clustered = max(pi[min_clustered], min_l);
 
   T sum = 0;
 
@@ -125,7 +125,7 @@ T S2_easy_128(T xp,
     uint64_t xpq = fast_div64(xp, primes[l]);
     uint64_t phi_xpq = pi[xpq] - b + 2;
     uint64_t xpq2 = fast_div64(xp, primes[b + phi_xpq - 1]);
-    uint64_t lmin = pi[xpq2];
+    uint64_t lmin = max(pi[xpq2], min_l);
     sum += phi_xpq * (l - lmin);
     l = lmin;
   }
@@ -135,7 +135,7 @@ T S2_easy_128(T xp,
   // pq = primes[b] * primes[l]
   // Which satisfy: pq > z && x / pq <= y
   // where phi(x / pq, b - 1) = pi(x / pq) - b + 2
-  for (; l > pi_min_sparse; l--)
+  for (; l > min_l; l--)
   {
     uint64_t xpq = fast_div64(xp, primes[l]);
     sum += pi[xpq] - b + 2;
@@ -163,6 +163,20 @@ T S2_easy_OpenMP(T x,
   for (std::size_t i = 1; i < lprimes.size(); i++)
     lprimes[i] = primes[i];
 
+#if defined(ENABLE_DIVIDER128)
+  // Initialize Divider128 vector from primes vector,
+  // only used by S2_easy_128() (xp >= 2^64).
+  pod_vector<Divider128> dprimes;
+  if (sizeof(T) > sizeof(uint64_t))
+  {
+    dprimes.resize(primes.size());
+    for (std::size_t i = 1; i < dprimes.size(); i++)
+      dprimes[i] = primes[i];
+  }
+#else
+  const Primes& dprimes = primes;
+#endif
+
   T sum = 0;
   int64_t x13 = iroot<3>(x); 
 
@@ -177,24 +191,46 @@ T S2_easy_OpenMP(T x,
   PiTable pi(y, threads);
   int64_t pi_sqrty = pi[isqrt(y)];
   int64_t pi_x13 = pi[x13];
-  RelaxedAtomic<int64_t> min_b(max(c, pi_sqrty) + 1);
+  TaskScheduler scheduler;
 
   // for (b = pi[sqrty] + 1; b <= pi_x13; b++)
-  #pragma omp parallel num_threads(threads) reduction(+: sum)
-  for (int64_t b = min_b++; b <= pi_x13; b = min_b++)
+  // The inner loop iterates over the easy leaves
+  // pi_min_sparse < l <= pi[min_trivial].
+  for (int64_t b = max(c, pi_sqrty) + 1; b <= pi_x13; b++)
   {
     int64_t prime = primes[b];
     T xp = x / prime;
+    int64_t min_trivial = min(xp / prime, y);
+    int64_t min_sparse = in_between(prime, z / prime, y);
+    int64_t start = pi[min_sparse] + 1;
+    int64_t stop = pi[min_trivial] + 1;
+    scheduler.add(b, start, stop, (double) (stop - start));
+  }
 
-    if (xp <= numeric_limits<uint64_t>::max())
-      sum += S2_easy_64(xp, y, z, b, prime, lprimes, pi);
-    else
-      sum += S2_easy_128(xp, y, z, b, prime, primes, pi);
+  scheduler.split(threads);
 
-    #pragma omp master
-    if (is_print)
-      status.print(b, pi_x13);
-  }
+  sum += parallel_sum<T>(threads, [&](int thread_num)
+  {
+    T sum = 0;
+
+    for (Task task; scheduler.get_task(task);)
+    {
+      int64_t b = task.b;
+      int64_t prime = primes[b];
+      T xp = x / prime;
+
+      if (xp <= numeric_limits<uint64_t>::max())
+        sum += S2_easy_64(xp, y, b, prime, task, lprimes, pi);
+      else
+        sum += S2_easy_128(xp, y, b, prime, task, dprimes, pi);
+
+      if (is_print &&
+          thread_num == 0)
+        status.print(b, pi_x13);
+    }
+
+    return sum;
+  });
 
   return sum;
 }
@@ -35,6 +35,8 @@
 #include "int128_t.hpp"
 #include "LoadBalancerS2.hpp"
 #include "min.hpp"
+#include "parallel.hpp"
+#include "pod_vector.hpp"
 #include "print.hpp"
 #include "S.hpp"
 
@@ -83,7 +85,8 @@ T S2_hard_thread(T x,
   if (min_b > max_b)
     return 0;
 
-  auto phi = generate_phi(low, max_b, primes, pi);
+  pod_vector<int64_t> phi = thread.get_phi(low, max_b, primes, pi);
+  int64_t phi_max_b = max_b + 1;
   Sieve sieve(low, segment_size, max_b);
   thread.init_finished();
 
@@ -163,8 +166,11 @@ T S2_hard_thread(T x,
     }
 
     next_segment:;
+    phi_max_b = min(phi_max_b, b);
   }
 
+  thread.save_phi(phi, limit, min_b, phi_max_b);
+
   return sum;
 }
 
@@ -204,11 +210,11 @@ T S2_hard_OpenMP(T x,
   threads = std::min(threads, max_threads);
   threads = ideal_num_threads(z, threads, thread_threshold);
 
-  LoadBalancerS2 loadBalancer(x, z, s2_hard_approx, threads, is_print);
+  LoadBalancerS2 loadBalancer("S2_hard", x, z, s2_hard_approx, threads, is_print);
   int64_t max_prime = min(y, z / isqrt(y));
   PiTable pi(max_prime, threads);
 
-  #pragma omp parallel num_threads(threads)
+  parallel_region(threads, [&](int)
   {
     ThreadData thread;
 
@@ -220,10 +226,10 @@ T S2_hard_OpenMP(T x,
 
       thread.start_time();
       UT sum = S2_hard_thread((UT) x, y, z, c, primes, pi, factor, thread);
-      thread.sum = (T) sum;
+      thread.sum += (T) sum;
       thread.stop_time();
     }
-  }
+  });
 
   T sum = (T) loadBalancer.get_sum();
 
@@ -21,8 +21,6 @@
 
 #include "primecount.hpp"
 #include "primecount-internal.hpp"
-#include "imath.hpp"
-#include "PhiTiny.hpp"
 #include "int128_t.hpp"
 #include "macros.hpp"
 #include "print.hpp"
@@ -71,12 +69,11 @@ int64_t pi_deleglise_rivat_64(int64_t x,
   if (x < 2)
     return 0;
 
-  double alpha = get_alpha_deleglise_rivat(x);
-  int64_t x13 = iroot<3>(x);
-  int64_t y = (int64_t) (x13 * alpha);
-  int64_t z = x / y;
+  DelegliseRivatVars v = get_deleglise_rivat_vars(x);
+  int64_t y = v.y;
+  int64_t z = v.z;
+  int64_t c = v.c;
   int64_t pi_y = pi_noprint(y, threads);
-  int64_t c = PhiTiny::get_c(y);
 
   if (is_print)
   {
@@ -116,10 +113,11 @@ int128_t pi_deleglise_rivat_128(int128_t x,
   if_unlikely(x > limit)
     throw primecount_error("pi(x): x must be <= " + to_string(limit));
 
-  int64_t y = (int64_t) (iroot<3>(x) * alpha);
-  int64_t z = (int64_t) (x / y);
+  DelegliseRivatVars v = get_deleglise_rivat_vars(x);
+  int64_t y = v.y;
+  int64_t z = v.z;
+  int64_t c = v.c;
   int64_t pi_y = pi_noprint(y, threads);
-  int64_t c = PhiTiny::get_c(y);
 
   if (is_print)
   {
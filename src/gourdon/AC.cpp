@@ -27,6 +27,8 @@
 
 #include "PiTable.hpp"
 #include "SegmentedPiTable.hpp"
+#include "TaskScheduler.hpp"
+#include "parallel.hpp"
 #include "primecount-internal.hpp"
 #include "LoadBalancerAC.hpp"
 #include "fast_div.hpp"
@@ -36,7 +38,6 @@
 #include "min.hpp"
 #include "imath.hpp"
 #include "print.hpp"
-#include "RelaxedAtomic.hpp"
 
 #include <stdint.h>
 
@@ -220,7 +221,7 @@ T AC_OpenMP(T x,
   int max_threads = (int) std::pow(xz, 1 / 3.7);
   threads = std::min(threads, max_threads);
   threads = ideal_num_threads(x13, threads, thread_threshold);
-  LoadBalancerAC loadBalancer(sqrtx, y, threads, is_print);
+  LoadBalancerAC loadBalancer("AC", sqrtx, y, threads, is_print);
 
   // PiTable's size = z because of the C1 formula.
   // PiTable is accessed much less frequently than
@@ -232,7 +233,22 @@ T AC_OpenMP(T x,
   int64_t pi_sqrtz = pi[isqrt(z)];
   int64_t pi_root3_xy = pi[iroot<3>(xy)];
   int64_t pi_root3_xz = pi[iroot<3>(xz)];
-  RelaxedAtomic<int64_t> min_c1(max(k, pi_root3_xz) + 1);
+
+  // C1 formula: pi[(x/z)^(1/3)] < b <= pi[sqrt(z)]
+  // The runtime of the b-th iteration is roughly
+  // proportional to max_m = x / primes[b]^2. The most
+  // expensive iterations are split into multiple tasks.
+  TaskScheduler c1_tasks;
+  for (int64_t b = max(k, pi_root3_xz) + 1; b <= pi_sqrtz; b++)
+  {
+    int64_t prime = primes[b];
+    T xp = x / prime;
+    int64_t max_m = min(xp / prime, z);
+    int64_t stop = min(pi[max_m], pi_y) + 1;
+    c1_tasks.add(b, b + 1, stop, (double) max_m);
+  }
+
+  c1_tasks.split(threads);
 
   // In order to reduce the thread creation & destruction
   // overhead we reuse the same threads throughout the
@@ -242,7 +258,7 @@ T AC_OpenMP(T x,
   // 2) Computation of the C2 formula.
   // 3) Computation of the A formula.
   //
-  #pragma omp parallel num_threads(threads) reduction(+: sum)
+  sum += parallel_sum<T>(threads, [&](int)
   {
     // SegmentedPiTable is accessed very frequently.
     // In order to get good performance it is important that
@@ -250,20 +266,27 @@ T AC_OpenMP(T x,
     // Hence we use a small segment_size of x^(1/4).
     SegmentedPiTable segmentedPi;
     int64_t low, high;
+    T sum = 0;
 
-    // C1 formula: pi[(x/z)^(1/3)] < b <= pi[pi_sqrtz]
-    // There are very few iterations in this loop,
-    // hence the use of an atomic loop counter (min_c1)
-    // won't cause any scaling issues.
-    for (int64_t b = min_c1++; b <= pi_sqrtz; b = min_c1++)
+    // C1 formula: pi[(x/z)^(1/3)] < b <= pi[sqrt(z)]
+    for (Task task; c1_tasks.get_task(task);)
     {
+      int64_t b = task.b;
       int64_t prime = primes[b];
       T xp = x / prime;
       int64_t max_m = min(xp / prime, z);
       T min_m128 = max(xp / (prime * prime), z / prime);
       int64_t min_m = min(min_m128, max_m);
 
-      sum -= C1<-1>(xp, b, b, pi_y, 1, min_m, max_m, primes, pi);
+      // Same as sum -= C1<-1>(xp, b, b, pi_y, 1, ...)
+      // but restricted to task.start <= i < task.stop.
+      for (int64_t i = task.start; i < task.stop; i++)
+      {
+        int64_t m = primes[i];
+        if (m > min_m)
+          sum += pi[fast_div64(xp, m)] - b + 2;
+        sum -= C1<1>(xp, b, i, pi_y, m, min_m, max_m, primes, pi);
+      }
     }
 
     // for (low = 0; low < sqrt; low += segment_size)
@@ -299,7 +322,9 @@ T AC_OpenMP(T x,
       for (int64_t b = min_a; b <= max_a; b++)
         sum += A(x, xlow, xhigh, y, b, primes, pi, segmentedPi);
     }
-  }
+
+    return sum;
+  });
 
   return sum;
 }
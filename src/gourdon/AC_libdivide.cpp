@@ -20,7 +20,10 @@
 ///        libdivide. libdivide allows to replace expensive integer
 ///        divsion instructions by a sequence of shift, add and
 ///        multiply instructions that will calculate the integer
-///        division much faster.
+///        division much faster. For xp >= 2^64 libdivide cannot
+///        be used, on CPUs without a (128-bit / 64-bit) division
+///        instruction we use Divider128 instead which divides
+///        using the precomputed reciprocals of the primes.
 ///
 ///        In-depth description of this algorithm:
 ///        https://github.com/kimwalisch/primecount/blob/master/doc/Easy-Special-Leaves.md
@@ -33,9 +36,12 @@
 
 #include "PiTable.hpp"
 #include "SegmentedPiTable.hpp"
+#include "TaskScheduler.hpp"
+#include "parallel.hpp"
 #include "primecount-internal.hpp"
 #include "LoadBalancerAC.hpp"
 #include "fast_div.hpp"
+#include "Divider128.hpp"
 #include "generate.hpp"
 #include "gourdon.hpp"
 #include "int128_t.hpp"
@@ -44,7 +50,6 @@
 #include "imath.hpp"
 #include "pod_vector.hpp"
 #include "print.hpp"
-#include "RelaxedAtomic.hpp"
 
 #include <stdint.h>
 
@@ -103,13 +108,13 @@ T A_64(T xlow,
 /// x / (primes[b] * primes[i]) < x^(1/2)
 ///
 template <typename T,
-          typename Primes>
+          typename DividerPrimes>
 T A_128(T xlow,
         T xhigh,
         T xp,
         uint64_t y,
         uint64_t prime,
-        const Primes& primes,
+        const DividerPrimes& primes,
         const PiTable& pi,
         const SegmentedPiTable& segmentedPi)
 {
@@ -252,19 +257,19 @@ T C2_64(T xlow,
 /// x / (primes[b] * primes[i]) < x^(1/2)
 ///
 template <typename T,
-          typename Primes>
+          typename DividerPrimes>
 T C2_128(T xlow,
          T xhigh,
          T xp,
          uint64_t y,
          uint64_t b,
-         const Primes& primes,
+         uint64_t prime,
+         const DividerPrimes& primes,
          const PiTable& pi,
          const SegmentedPiTable& segmentedPi)
 {
   T sum = 0;
 
-  uint64_t prime = primes[b];
   uint64_t max_m = min3(xlow / prime, xp / prime, y);
   T min_m128 = max3(xhigh / prime, xp / (prime * prime), prime);
   uint64_t min_m = min(min_m128, max_m);
@@ -329,7 +334,7 @@ T AC_OpenMP(T x,
   int max_threads = (int) std::pow(xz, 1 / 3.7);
   threads = std::min(threads, max_threads);
   threads = ideal_num_threads(x13, threads, thread_threshold);
-  LoadBalancerAC loadBalancer(sqrtx, y, threads, is_print);
+  LoadBalancerAC loadBalancer("AC", sqrtx, y, threads, is_print);
 
   // Initialize libdivide vector from primes vector
   pod_vector<libdivide::branchfree_divider<uint64_t>> lprimes;
@@ -337,6 +342,20 @@ T AC_OpenMP(T x,
   for (std::size_t i = 1; i < lprimes.size(); i++)
     lprimes[i] = primes[i];
 
+#if defined(ENABLE_DIVIDER128)
+  // Initialize Divider128 vector from primes vector,
+  // only used by the 128-bit functions (xp >= 2^64).
+  pod_vector<Divider128> dprimes;
+  if (sizeof(T) > sizeof(uint64_t))
+  {
+    dprimes.resize(primes.size());
+    for (std::size_t i = 1; i < dprimes.size(); i++)
+      dprimes[i] = primes[i];
+  }
+#else
+  const Primes& dprimes = primes;
+#endif
+
   // PiTable's size = z because of the C1 formula.
   // PiTable is accessed much less frequently than
   // SegmentedPiTable, hence it is OK that PiTable's size
@@ -347,7 +366,22 @@ T AC_OpenMP(T x,
   int64_t pi_sqrtz = pi[isqrt(z)];
   int64_t pi_root3_xy = pi[iroot<3>(xy)];
   int64_t pi_root3_xz = pi[iroot<3>(xz)];
-  RelaxedAtomic<int64_t> min_c1(max(k, pi_root3_xz) + 1);
+
+  // C1 formula: pi[(x/z)^(1/3)] < b <= pi[sqrt(z)]
+  // The runtime of the b-th iteration is roughly
+  // proportional to max_m = x / primes[b]^2. The most
+  // expensive iterations are split into multiple tasks.
+  TaskScheduler c1_tasks;
+  for (int64_t b = max(k, pi_root3_xz) + 1; b <= pi_sqrtz; b++)
+  {
+    int64_t prime = primes[b];
+    T xp = x / prime;
+    int64_t max_m = min(xp / prime, z);
+    int64_t stop = min(pi[max_m], pi_y) + 1;
+    c1_tasks.add(b, b + 1, stop, (double) max_m);
+  }
+
+  c1_tasks.split(threads);
 
   // In order to reduce the thread creation & destruction
   // overhead we reuse the same threads throughout the
@@ -357,7 +391,7 @@ T AC_OpenMP(T x,
   // 2) Computation of the C2 formula.
   // 3) Computation of the A formula.
   //
-  #pragma omp parallel num_threads(threads) reduction(+: sum)
+  sum += parallel_sum<T>(threads, [&](int)
   {
     // SegmentedPiTable is accessed very frequently.
     // In order to get good performance it is important that
@@ -365,20 +399,27 @@ T AC_OpenMP(T x,
     // Hence we use a small segment_size of x^(1/4).
     SegmentedPiTable segmentedPi;
     int64_t low, high;
+    T sum = 0;
 
-    // C1 formula: pi[(x/z)^(1/3)] < b <= pi[pi_sqrtz]
-    // There are very few iterations in this loop,
-    // hence the use of an atomic loop counter (min_c1)
-    // won't cause any scaling issues.
-    for (int64_t b = min_c1++; b <= pi_sqrtz; b = min_c1++)
+    // C1 formula: pi[(x/z)^(1/3)] < b <= pi[sqrt(z)]
+    for (Task task; c1_tasks.get_task(task);)
     {
+      int64_t b = task.b;
       int64_t prime = primes[b];
       T xp = x / prime;
       int64_t max_m = min(xp / prime, z);
       T min_m128 = max(xp / (prime * prime), z / prime);
       int64_t min_m = min(min_m128, max_m);
 
-      sum -= C1<-1>(xp, b, b, pi_y, 1, min_m, max_m, primes, pi);
+      // Same as sum -= C1<-1>(xp, b, b, pi_y, 1, ...)
+      // but restricted to task.start <= i < task.stop.
+      for (int64_t i = task.start; i < task.stop; i++)
+      {
+        int64_t m = primes[i];
+        if (m > min_m)
+          sum += pi[fast_div64(xp, m)] - b + 2;
+        sum -= C1<1>(xp, b, i, pi_y, m, min_m, max_m, primes, pi);
+      }
     }
 
     // for (low = 0; low < sqrt; low += segment_size)
@@ -415,7 +456,7 @@ T AC_OpenMP(T x,
         if (xp <= numeric_limits<uint64_t>::max())
           sum += C2_64(xlow, xhigh, (uint64_t) xp, y, b, prime, lprimes, pi, segmentedPi);
         else
-          sum += C2_128(xlow, xhigh, xp, y, b, primes, pi, segmentedPi);
+          sum += C2_128(xlow, xhigh, xp, y, b, prime, dprimes, pi, segmentedPi);
       }
 
       // A formula: pi[x_star] < b <= pi[x13]
@@ -427,10 +468,12 @@ T AC_OpenMP(T x,
         if (xp <= numeric_limits<uint64_t>::max())
           sum += A_64(xlow, xhigh, (uint64_t) xp, y, prime, lprimes, pi, segmentedPi);
         else
-          sum += A_128(xlow, xhigh, xp, y, prime, primes, pi, segmentedPi);
+          sum += A_128(xlow, xhigh, xp, y, prime, dprimes, pi, segmentedPi);
       }
     }
-  }
+
+    return sum;
+  });
 
   return sum;
 }
@@ -24,21 +24,41 @@
 #include "macros.hpp"
 #include "min.hpp"
 #include "imath.hpp"
+#include "parallel.hpp"
 #include "print.hpp"
 
 #include <stdint.h>
 #include <algorithm>
+#include <vector>
 
 using namespace primecount;
 
 namespace {
 
+/// Result of sieving [low, high[. The thread does not
+/// know pi(low), hence it computes the sum of
+/// pi(x / prime) - pi(low) and the number of primes.
+/// pi(low) is added later using a prefix sum over the
+/// prime counts of the previous chunks.
+///
+template <typename T>
+struct Chunk
+{
+  int64_t low;
+  /// \sum pi(x / prime) - pi(low)
+  T sum;
+  /// Number of primes in the sum
+  int64_t primes;
+  /// Number of primes inside ]low, high]
+  int64_t count;
+};
+
 /// Thread sieves [low, high[
 template <typename T>
-T B_thread(T x,
-           int64_t y,
-           int64_t low,
-           int64_t high)
+Chunk<T> B_thread(T x,
+                  int64_t y,
+                  int64_t low,
+                  int64_t high)
 {
   ASSERT(low > 0);
   ASSERT(low < high);
@@ -48,33 +68,72 @@ T B_thread(T x,
   primesieve::iterator it1(stop, start);
   int64_t prime = it1.prev_prime();
 
-  if (prime <= start)
-    return 0;
-
-  // The first iteration requires computing pi(x / prime)
-  // using the prime counting function.
-  int threads = 1;
-  uint64_t xp = (uint64_t)(x / prime);
-  int64_t pi_xp = pi_noprint(xp, threads);
-  T sum = pi_xp;
-  prime = it1.prev_prime();
-
-  // All other iterations compute pi(x / prime)
-  // using a prime sieve.
-  primesieve::iterator it2(xp + 1, high);
+  Chunk<T> chunk;
+  chunk.low = low;
+  chunk.sum = 0;
+  chunk.primes = 0;
+
+  // pi(x / prime) - pi(low) is computed using
+  // a prime sieve, the primes inside ]low, xp].
+  // We count the primes of primesieve::iterator's
+  // buffer which is small and stays in the CPU cache.
+  // This runs as fast as primesieve::count_primes()
+  // and 2x - 3x faster than counting the 1 bits of
+  // our Sieve class (used for the hard special leaves)
+  // as primesieve uses much faster sieving algorithms.
+  int64_t pi_xp = 0;
+  primesieve::iterator it2(low + 1, high);
   it2.generate_next_primes();
 
-  // \sum_{i = pi[start]+1}^{pi[stop]} pi(x / primes[i])
+  // \sum_{i = pi[start]+1}^{pi[stop]} pi(x / primes[i]) - pi(low)
   for (; prime > start; prime = it1.prev_prime())
   {
-    xp = (uint64_t)(x / prime);
+    uint64_t xp = (uint64_t)(x / prime);
 
     for (; it2.primes_[it2.size_ - 1] <= xp; it2.generate_next_primes())
       pi_xp += it2.size_ - it2.i_;
     for (; it2.primes_[it2.i_] <= xp; it2.i_++)
       pi_xp += 1;
 
-    sum += pi_xp;
+    chunk.sum += pi_xp;
+    chunk.primes += 1;
+  }
+
+  // Count the remaining primes <= high
+  for (; it2.primes_[it2.size_ - 1] <= (uint64_t) high; it2.generate_next_primes())
+    pi_xp += it2.size_ - it2.i_;
+  for (; it2.primes_[it2.i_] <= (uint64_t) high; it2.i_++)
+    pi_xp += 1;
+
+  chunk.count = pi_xp;
+
+  return chunk;
+}
+
+/// Add pi(low) to the sum of each chunk. The chunks
+/// cover [sqrt(x), x / y[ without gaps, hence pi(low) of
+/// each chunk is pi(sqrt(x)) + the prime counts of the
+/// previous chunks.
+///
+template <typename T>
+T sum_chunks(const std::vector<std::vector<Chunk<T>>>& thread_chunks,
+             T pi_low)
+{
+  std::vector<Chunk<T>> chunks;
+  for (const auto& c : thread_chunks)
+    chunks.insert(chunks.end(), c.begin(), c.end());
+
+  std::sort(chunks.begin(), chunks.end(),
+    [](const Chunk<T>& a, const Chunk<T>& b) {
+      return a.low < b.low;
+  });
+
+  T sum = 0;
+
+  for (const Chunk<T>& chunk : chunks)
+  {
+    sum += chunk.sum + chunk.primes * pi_low;
+    pi_low += chunk.count;
   }
 
   return sum;
@@ -95,16 +154,21 @@ T B_OpenMP(T x,
 
   T sum = 0;
   int64_t xy = (int64_t)(x / max(y, 1));
-  LoadBalancerP2 loadBalancer(x, xy, threads, is_print);
+  LoadBalancerP2 loadBalancer("B", x, xy, threads, is_print);
   threads = loadBalancer.get_threads();
 
+  std::vector<std::vector<Chunk<T>>> chunks(threads);
+
   // for (low = sqrt(x); low < x / y; low += dist)
-  #pragma omp parallel num_threads(threads) reduction(+:sum)
+  parallel_region(threads, [&](int t)
   {
     int64_t low, high;
     while (loadBalancer.get_work(low, high))
-      sum += B_thread(x, y, low, high);
-  }
+      chunks[t].push_back(B_thread(x, y, low, high));
+  });
+
+  T pi_sqrtx = pi_noprint(isqrt(x), threads);
+  sum += sum_chunks(chunks, pi_sqrtx);
 
   return sum;
 }
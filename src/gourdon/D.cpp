@@ -15,6 +15,16 @@
 ///        compressed lookup table of moebius function values,
 ///        least prime factors and max prime factors.
 ///
+///        The FactorTableD is generated for the whole interval
+///        [1, z] before the threads start. For each b a thread only
+///        accesses a small window of m values, however the union of
+///        these windows over all b of a thread's interval
+///        [low, low + segments * segment_size[ spans most of
+///        [sqrt(z), z] (except for the first and last few intervals).
+///        Hence generating the FactorTableD on demand for each
+///        thread interval would not reduce the memory usage, it
+///        would only factor the same numbers over and over again.
+///
 /// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
 ///
 /// This file is distributed under the BSD License. See the COPYING
@@ -33,6 +43,8 @@
 #include "imath.hpp"
 #include "int128_t.hpp"
 #include "min.hpp"
+#include "parallel.hpp"
+#include "pod_vector.hpp"
 #include "print.hpp"
 
 #include <stdint.h>
@@ -72,7 +84,8 @@ T D_thread(T x,
   if (min_b > max_b)
     return 0;
 
-  auto phi = generate_phi(low, max_b, primes, pi);
+  pod_vector<int64_t> phi = thread.get_phi(low, max_b, primes, pi);
+  int64_t phi_max_b = max_b + 1;
   Sieve sieve(low, segment_size, max_b);
   thread.init_finished();
 
@@ -106,13 +119,14 @@ T D_thread(T x,
 
       min_m = factor.to_index(min_m);
       max_m = factor.to_index(max_m);
+      int64_t leaf_key = factor.leaf_key(b);
 
       for (int64_t m = max_m; m > min_m; m--)
       {
         // mu[m] != 0 && 
         // lpf[m] > prime &&
         // mpf[m] <= y
-        if (prime < factor.is_leaf(m))
+        if (leaf_key < factor.is_leaf(m))
         {
           int64_t xpm = fast_div64(xp, factor.to_number(m));
           int64_t stop = xpm - low;
@@ -156,8 +170,11 @@ T D_thread(T x,
     }
 
     next_segment:;
+    phi_max_b = min(phi_max_b, b);
   }
 
+  thread.save_phi(phi, limit, min_b, phi_max_b);
+
   return sum;
 }
 
@@ -199,10 +216,10 @@ T D_OpenMP(T x,
   int max_threads = (int) std::pow(xz, 1 / 3.7);
   threads = std::min(threads, max_threads);
   threads = ideal_num_threads(xz, threads, thread_threshold);
-  LoadBalancerS2 loadBalancer(x, xz, d_approx, threads, is_print);
+  LoadBalancerS2 loadBalancer("D", x, xz, d_approx, threads, is_print);
   PiTable pi(y, threads);
 
-  #pragma omp parallel num_threads(threads)
+  parallel_region(threads, [&](int)
   {
     ThreadData thread;
 
@@ -214,10 +231,10 @@ T D_OpenMP(T x,
 
       thread.start_time();
       UT sum = D_thread((UT) x, x_star, xz, y, z, k, primes, pi, factor, thread);
-      thread.sum = (T) sum;
+      thread.sum += (T) sum;
       thread.stop_time();
     }
-  }
+  });
 
   T sum = (T) loadBalancer.get_sum();
 
@@ -14,6 +14,8 @@
 ///
 
 #include "LoadBalancerAC.hpp"
+#include "primecount.hpp"
+#include "print.hpp"
 #include "SegmentedPiTable.hpp"
 #include "primecount-config.hpp"
 #include "primecount-internal.hpp"
@@ -36,15 +38,20 @@ constexpr int64_t l2_segment_size = L2_CACHE_SIZE * numbers_per_byte;
 
 namespace primecount {
 
-LoadBalancerAC::LoadBalancerAC(int64_t sqrtx,
+LoadBalancerAC::LoadBalancerAC(const char* formula,
+                               int64_t sqrtx,
                                int64_t y,
                                int threads,
                                bool is_print) :
   sqrtx_(sqrtx),
   x14_(isqrt(sqrtx)),
   y_(y),
+  start_time_(get_time()),
+  progress_time_(start_time_),
+  formula_(formula),
   threads_(threads),
-  is_print_(is_print)
+  is_print_(is_print),
+  token_(get_cancellation_token())
 {
   lock_.init(threads);
 
@@ -81,9 +88,28 @@ LoadBalancerAC::LoadBalancerAC(int64_t sqrtx,
 
 bool LoadBalancerAC::get_work(int64_t& low, int64_t& high)
 {
-  LockGuard lockGuard(lock_);
+  Progress progress;
+  bool is_progress = false;
+  bool is_work;
 
-  if (low_ >= sqrtx_)
+  {
+    LockGuard lockGuard(lock_);
+    is_work = next_work(low, high);
+    is_progress = update_progress(progress);
+  }
+
+  // Invoke the progress callback outside of the lock
+  if (is_progress)
+    progress_.report(progress);
+
+  return is_work;
+}
+
+/// Must be called while holding the lock
+bool LoadBalancerAC::next_work(int64_t& low, int64_t& high)
+{
+  if (low_ >= sqrtx_ ||
+      is_cancelled())
     return false;
 
   // Most special leaves are below y (~ x^(1/3) * log(x)).
@@ -104,6 +130,28 @@ bool LoadBalancerAC::get_work(int64_t& low, int64_t& high)
   return low < sqrtx_;
 }
 
+/// Must be called while holding the lock. Returns true
+/// if progress has been filled in and needs to be reported.
+///
+bool LoadBalancerAC::update_progress(Progress& progress)
+{
+  if (!progress_.is_due(progress_time_))
+    return false;
+
+  progress.formula = formula_;
+  progress.percent = get_percent(segment_nr_, total_segments_);
+  progress.remaining_secs = get_remaining_secs(start_time_, progress.percent);
+  return true;
+}
+
+/// Stop handing out work if the pi_async()
+/// computation has been cancelled.
+///
+bool LoadBalancerAC::is_cancelled() const
+{
+  return token_ && token_->is_cancelled();
+}
+
 void LoadBalancerAC::validate_segment_sizes()
 {
   segment_size_ = std::max(min_segment_size, segment_size_);
@@ -26,9 +26,12 @@
 #include "imath.hpp"
 #include "int128_t.hpp"
 #include "print.hpp"
+#include "parallel.hpp"
 #include "pod_vector.hpp"
+#include "TaskScheduler.hpp"
 
 #include <stdint.h>
+#include <algorithm>
 
 using std::numeric_limits;
 using namespace primecount;
@@ -82,14 +85,46 @@ X Phi0_OpenMP(X x,
   auto primes = generate_primes<Y>(y);
   int64_t pi_y = primes.size() - 1;
   X phi0 = phi_tiny(x, k);
+  TaskScheduler scheduler;
 
-  #pragma omp parallel for schedule(static, 1) num_threads(threads) reduction (+: phi0)
+  // The runtime of the b-th iteration is roughly
+  // proportional to z / primes[b]. The inner loop
+  // iterates over the primes[i] > primes[b] with
+  // primes[b] * primes[i] <= z.
   for (int64_t b = k + 1; b <= pi_y; b++)
   {
-    phi0 -= phi_tiny(x / primes[b], k);
-    phi0 += Phi0_thread<1>(x, z, b, k, (X) primes[b], primes);
+    int64_t max_m = z / primes[b];
+    auto first = primes.begin() + b + 1;
+    auto last = std::upper_bound(first, primes.end(), max_m);
+    int64_t stop = last - primes.begin();
+    scheduler.add(b, b + 1, stop, (double) max_m);
   }
 
+  scheduler.split(threads);
+
+  phi0 += parallel_sum<X>(threads, [&](int)
+  {
+    X phi0 = 0;
+
+    for (Task task; scheduler.get_task(task);)
+    {
+      int64_t b = task.b;
+      X prime = primes[b];
+
+      if (task.start == b + 1)
+        phi0 -= phi_tiny(x / prime, k);
+
+      for (int64_t i = task.start; i < task.stop; i++)
+      {
+        X next = prime * primes[i];
+        phi0 += phi_tiny(x / next, k);
+        phi0 += Phi0_thread<-1>(x, z, i, k, next, primes);
+      }
+    }
+
+    return phi0;
+  });
+
   return phi0;
 }
 
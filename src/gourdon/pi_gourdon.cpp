@@ -18,14 +18,11 @@
 #include "gourdon.hpp"
 #include "primecount.hpp"
 #include "primecount-internal.hpp"
-#include "imath.hpp"
 #include "macros.hpp"
-#include "PhiTiny.hpp"
 #include "print.hpp"
 #include "to_string.hpp"
 
 #include <stdint.h>
-#include <algorithm>
 #include <string>
 
 namespace primecount {
@@ -42,25 +39,10 @@ int64_t pi_gourdon_64(int64_t x,
   if (x < 2)
     return 0;
 
-  auto alpha = get_alpha_gourdon(x);
-  double alpha_y = alpha.first;
-  double alpha_z = alpha.second;
-  int64_t x13 = iroot<3>(x);
-  int64_t sqrtx = isqrt(x);
-  int64_t y = (int64_t)(x13 * alpha_y);
-
-  // x^(1/3) < y < x^(1/2)
-  y = std::max(y, x13 + 1);
-  y = std::min(y, sqrtx - 1);
-  y = std::max(y, (int64_t) 1);
-
-  int64_t k = PhiTiny::get_k(x);
-  int64_t z = (int64_t)(y * alpha_z);
-
-  // y <= z < x^(1/2)
-  z = std::max(z, y);
-  z = std::min(z, sqrtx - 1);
-  z = std::max(z, (int64_t) 1);
+  GourdonVars v = get_gourdon_vars(x);
+  int64_t y = v.y;
+  int64_t z = v.z;
+  int64_t k = v.k;
 
   if (is_print)
   {
@@ -105,30 +87,16 @@ int128_t pi_gourdon_128(int128_t x,
   if (x < 2)
     return 0;
 
-  auto alpha = get_alpha_gourdon(x);
-  double alpha_y = alpha.first;
-  double alpha_z = alpha.second;
+  double alpha_y = get_alpha_gourdon(x).first;
   maxint_t limit = get_max_x(alpha_y);
 
   if_unlikely(x > limit)
     throw primecount_error("pi(x): x must be <= " + to_string(limit));
 
-  int64_t x13 = iroot<3>(x);
-  int64_t sqrtx = isqrt(x);
-  int64_t y = (int64_t)(x13 * alpha_y);
-
-  // x^(1/3) < y < x^(1/2)
-  y = std::max(y, x13 + 1);
-  y = std::min(y, sqrtx - 1);
-  y = std::max(y, (int64_t) 1);
-
-  int64_t k = PhiTiny::get_k(x);
-  int64_t z = (int64_t)(y * alpha_z);
-
-  // y <= z < x^(1/2)
-  z = std::max(z, y);
-  z = std::min(z, sqrtx - 1);
-  z = std::max(z, (int64_t) 1);
+  GourdonVars v = get_gourdon_vars(x);
+  int64_t y = v.y;
+  int64_t z = v.z;
+  int64_t k = v.k;
 
   if (is_print)
   {
@@ -33,6 +33,7 @@
 #include "imath.hpp"
 #include "PhiTiny.hpp"
 #include "PiTable.hpp"
+#include "parallel.hpp"
 #include "print.hpp"
 #include "pod_vector.hpp"
 #include "S.hpp"
@@ -70,7 +71,8 @@ int64_t S2_thread(int64_t x,
   if (min_b > max_b)
     return 0;
 
-  auto phi = generate_phi(low, max_b, primes, pi);
+  pod_vector<int64_t> phi = thread.get_phi(low, max_b, primes, pi);
+  int64_t phi_max_b = max_b + 1;
   Sieve sieve(low, segment_size, max_b);
   thread.init_finished();
 
@@ -140,8 +142,11 @@ int64_t S2_thread(int64_t x,
     }
 
     next_segment:;
+    phi_max_b = min(phi_max_b, b);
   }
 
+  thread.save_phi(phi, limit, min_b, phi_max_b);
+
   return sum;
 }
 
@@ -189,20 +194,20 @@ int64_t S2(int64_t x,
   int max_threads = (int) std::pow(z, 1 / 3.7);
   threads = std::min(threads, max_threads);
   threads = ideal_num_threads(z, threads, thread_threshold);
-  LoadBalancerS2 loadBalancer(x, z, s2_approx, threads, is_print);
+  LoadBalancerS2 loadBalancer("S2", x, z, s2_approx, threads, is_print);
   PiTable pi(y, threads);
 
-  #pragma omp parallel num_threads(threads)
+  parallel_region(threads, [&](int)
   {
     ThreadData thread;
 
     while (loadBalancer.get_work(thread))
     {
       thread.start_time();
-      thread.sum = S2_thread(x, y, z, c, pi, primes, lpf, mu, thread);
+      thread.sum += S2_thread(x, y, z, c, pi, primes, lpf, mu, thread);
       thread.stop_time();
     }
-  }
+  });
 
   int64_t sum = (int64_t) loadBalancer.get_sum();
 
@@ -11,13 +11,22 @@
 #include "primecount.hpp"
 #include "primecount-internal.hpp"
 #include "primesieve.hpp"
+#include "IntervalSieve.hpp"
 #include "PiTable.hpp"
+#include "parallel.hpp"
 #include "pod_vector.hpp"
+#include "int128_t.hpp"
 #include "imath.hpp"
+#include "isqrt.hpp"
 #include "macros.hpp"
+#include "to_string.hpp"
 
 #include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <string>
+#include <vector>
 
 using namespace primecount;
 
@@ -69,6 +78,207 @@ int64_t binary_search_nth_prime(int64_t n)
   return low;
 }
 
+/// Find the nth prime > low - 1, count_low = pi(low - 1).
+/// The distance to the nth prime is split into chunks
+/// whose primes are counted in parallel. Then we
+/// continue in the chunk that contains the nth prime
+/// until the remaining distance is small.
+///
+int64_t next_nth_prime(int64_t n,
+                       int64_t count_low,
+                       uint64_t low,
+                       int64_t avg_prime_gap,
+                       int threads)
+{
+  int64_t thread_threshold = (int64_t) 1e7;
+  uint64_t max_dist = std::numeric_limits<uint64_t>::max();
+  int max_threads = threads;
+
+  while (true)
+  {
+    uint64_t dist = (n - count_low) * avg_prime_gap;
+    dist = std::min(dist, max_dist);
+    threads = ideal_num_threads(dist, max_threads, thread_threshold);
+    if (threads <= 1)
+      break;
+
+    uint64_t chunk = dist / threads;
+    std::vector<int64_t> counts(threads);
+
+    parallel_region(threads, [&](int t)
+    {
+      uint64_t start = low + chunk * t;
+      counts[t] = (int64_t) count_primes_sieve(start, start + chunk - 1, 1);
+    });
+
+    max_dist = std::numeric_limits<uint64_t>::max();
+
+    for (int t = 0; t < threads; t++)
+    {
+      // The nth prime is located inside the
+      // current chunk, hence the distance of
+      // the next iteration is <= chunk.
+      if (count_low + counts[t] >= n)
+      {
+        max_dist = chunk;
+        break;
+      }
+
+      count_low += counts[t];
+      low += chunk;
+    }
+  }
+
+  int64_t prime = -1;
+  uint64_t stop = low + (n - count_low) * avg_prime_gap;
+  primesieve::iterator iter(low, stop);
+  for (int64_t i = count_low; i < n; i++)
+    prime = iter.next_prime();
+
+  return prime;
+}
+
+/// Find the nth prime <= high, count_high = pi(high).
+/// Same algorithm as next_nth_prime() but the chunks
+/// are located below high.
+///
+int64_t prev_nth_prime(int64_t n,
+                       int64_t count_high,
+                       uint64_t high,
+                       int64_t avg_prime_gap,
+                       int threads)
+{
+  int64_t thread_threshold = (int64_t) 1e7;
+  uint64_t max_dist = high;
+  int max_threads = threads;
+
+  while (true)
+  {
+    uint64_t dist = (count_high - n + 1) * avg_prime_gap;
+    dist = std::min(dist, max_dist);
+    threads = ideal_num_threads(dist, max_threads, thread_threshold);
+    if (threads <= 1)
+      break;
+
+    uint64_t chunk = dist / threads;
+    std::vector<int64_t> counts(threads);
+
+    parallel_region(threads, [&](int t)
+    {
+      uint64_t stop = high - chunk * t;
+      counts[t] = (int64_t) count_primes_sieve(stop - chunk + 1, stop, 1);
+    });
+
+    max_dist = high;
+
+    for (int t = 0; t < threads; t++)
+    {
+      if (count_high - counts[t] < n)
+      {
+        max_dist = chunk;
+        break;
+      }
+
+      count_high -= counts[t];
+      high -= chunk;
+    }
+
+    max_dist = std::min(max_dist, high);
+  }
+
+  int64_t prime = -1;
+  uint64_t dist = (count_high - n + 1) * avg_prime_gap;
+  uint64_t stop = high - std::min(high, dist);
+  primesieve::iterator iter(high, stop);
+  for (int64_t i = count_high; i + 1 > n; i--)
+    prime = iter.prev_prime();
+
+  return prime;
+}
+
+#if defined(HAVE_INT128_T)
+
+// Number of primes < 2^64
+constexpr int128_t pi_2_64 = 425656284035217743ll;
+
+/// The segment size is the estimated distance to the nth prime
+/// capped at sieve.segment_size(). Each segment requires
+/// generating the sieving primes <= sqrt(high), hence we
+/// sieve at least sqrt(high) / 64 integers per segment. This
+/// is fast compared to generating the sieving primes and
+/// the nth prime is usually found in the first segment.
+///
+uint64_t get_segment_size(const IntervalSieve& sieve, double dist, uint128_t high)
+{
+  uint64_t max_segment = sieve.segment_size();
+  uint64_t sqrt_high = (uint64_t) isqrt(high);
+  uint64_t min_segment = std::min(sqrt_high / 64, max_segment);
+  dist = std::min(dist, (double) max_segment);
+  return in_between(min_segment, (uint64_t) dist, max_segment);
+}
+
+/// Find the nth prime > low - 1, count_low = pi(low - 1).
+/// primesieve is limited to numbers < 2^64, hence we use the
+/// IntervalSieve instead. We sieve one segment after another
+/// (using all threads) and count its primes until we reach
+/// the segment that contains the nth prime.
+///
+int128_t next_nth_prime(int128_t n,
+                        int128_t count_low,
+                        uint128_t low,
+                        int threads)
+{
+  IntervalSieve sieve(threads);
+  double avg_prime_gap = std::log((double) low) + 2;
+
+  while (true)
+  {
+    double dist = (double) (n - count_low) * avg_prime_gap;
+    uint64_t segment_size = get_segment_size(sieve, dist, low + (uint128_t) dist);
+    uint128_t high = low + (segment_size - 1);
+
+    sieve.sieve(low, high);
+    int64_t count = sieve.count();
+
+    if (count_low + count >= n)
+      return sieve.nth_prime((uint64_t) (n - count_low));
+
+    count_low += count;
+    low = high + 1;
+  }
+}
+
+/// Find the nth prime <= high, count_high = pi(high).
+/// Same algorithm as next_nth_prime() but the
+/// segments are located below high.
+///
+int128_t prev_nth_prime(int128_t n,
+                        int128_t count_high,
+                        uint128_t high,
+                        int threads)
+{
+  IntervalSieve sieve(threads);
+  double avg_prime_gap = std::log((double) high) + 2;
+
+  while (true)
+  {
+    double dist = (double) (count_high - n + 1) * avg_prime_gap;
+    uint64_t segment_size = get_segment_size(sieve, dist, high);
+    uint128_t low = high - (segment_size - 1);
+
+    sieve.sieve(low, high);
+    int64_t count = sieve.count();
+
+    if (count_high - count < n)
+      return sieve.nth_prime_desc((uint64_t) (count_high - n + 1));
+
+    count_high -= count;
+    high = low - 1;
+  }
+}
+
+#endif
+
 } // namespace
 
 namespace primecount {
@@ -106,28 +316,73 @@ int64_t nth_prime(int64_t n, int threads)
   // and the segmented sieve of Eratosthenes.
   int64_t count_approx = pi(prime_approx, threads);
   int64_t avg_prime_gap =  ilog(prime_approx) + 2;
-  int64_t prime = -1;
 
-  // Here we are very close to the nth prime < sqrt(nth_prime),
-  // we simply iterate over the primes until we find it.
+  // Here we are very close to the nth prime < sqrt(nth_prime).
+  // For large n the distance to the nth prime is counted
+  // in parallel, then we simply iterate over the primes
+  // until we find it.
   if (count_approx < n)
+    return next_nth_prime(n, count_approx, prime_approx + 1, avg_prime_gap, threads);
+  else // if (count_approx >= n)
+    return prev_nth_prime(n, count_approx, prime_approx, avg_prime_gap, threads);
+}
+
+#if defined(HAVE_INT128_T)
+
+/// Find the nth prime using the prime counting function
+/// and the segmented sieve of Eratosthenes.
+/// @pre n <= 10^29
+///
+int128_t nth_prime(int128_t n, int threads)
+{
+  // nth_prime(10^29) < 10^31 = get_max_x()
+  int128_t max_n_128 = ipow((int128_t) 10, 29);
+
+  if (n <= max_n)
+    return nth_prime((int64_t) n, threads);
+  if_unlikely(n > max_n_128)
+    throw primecount_error("nth_prime(n): n must be <= " + to_string(max_n_128));
+
+  // Each segment of the sieve of Eratosthenes needs all
+  // sieving primes <= sqrt(x), hence we only sieve up to
+  // 4 segments, if the nth prime is further away we
+  // compute pi(x) once more closer to the nth prime.
+  double max_dist = (double) IntervalSieve::max_segment_size() * threads * 4;
+  int128_t prime_approx = Ri_inverse(n);
+  int128_t count_approx;
+
+  // pi(2^63) and pi(2^64) are known, if the nth prime
+  // is close to 2^63 or 2^64 we don't need to compute pi(x).
+  if ((double) (n - max_n) * (63 * std::log(2.0)) <= max_dist)
   {
-    uint64_t start = prime_approx + 1;
-    uint64_t stop = start + (n - count_approx) * avg_prime_gap;
-    primesieve::iterator iter(start, stop);
-    for (int64_t i = count_approx; i < n; i++)
-      prime = iter.next_prime();
+    prime_approx = (int128_t) 1 << 63;
+    count_approx = max_n;
   }
-  else // if (count_approx >= n)
+  else if (std::abs((double) (n - pi_2_64)) * (64 * std::log(2.0)) <= max_dist)
   {
-    uint64_t start = prime_approx;
-    uint64_t stop = start - (count_approx - n) * avg_prime_gap;
-    primesieve::iterator iter(start, stop);
-    for (int64_t i = count_approx; i + 1 > n; i--)
-      prime = iter.prev_prime();
+    prime_approx = (int128_t) 1 << 64;
+    count_approx = pi_2_64;
   }
+  else
+    count_approx = pi(prime_approx, threads);
 
-  return prime;
+  while (true)
+  {
+    double log_approx = std::log((double) prime_approx);
+    double dist = (double) (n - count_approx) * log_approx;
+    if (std::abs(dist) <= max_dist)
+      break;
+
+    prime_approx += (int128_t) dist;
+    count_approx = pi(prime_approx, threads);
+  }
+
+  if (count_approx < n)
+    return next_nth_prime(n, count_approx, prime_approx + 1, threads);
+  else // if (count_approx >= n)
+    return prev_nth_prime(n, count_approx, prime_approx, threads);
 }
 
+#endif
+
 } // namespace
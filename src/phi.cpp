@@ -29,11 +29,13 @@
 #include "imath.hpp"
 #include "macros.hpp"
 #include "min.hpp"
+#include "parallel.hpp"
 #include "PhiTiny.hpp"
 #include "PiTable.hpp"
 #include "print.hpp"
 #include "pod_vector.hpp"
 #include "popcnt.hpp"
+#include "RelaxedAtomic.hpp"
 
 #include <stdint.h>
 #include <algorithm>
@@ -385,16 +387,20 @@ int64_t phi_OpenMP(int64_t x, int64_t a, int threads)
   threads = std::min(threads, max_threads);
   threads = ideal_num_threads(x, threads, thread_threshold);
 
-  #pragma omp parallel num_threads(threads) reduction(+: sum)
+  RelaxedAtomic<int64_t> min_i(c + 1);
+
+  sum += parallel_sum<int64_t>(threads, [&](int)
   {
     // Each thread uses its own PhiCache object in
     // order to avoid thread synchronization.
     PhiCache cache(x, a, primes, pi);
+    int64_t sum = 0;
 
-    #pragma omp for nowait schedule(dynamic, 16)
-    for (int64_t i = c + 1; i <= a; i++)
+    for (int64_t i = min_i++; i <= a; i = min_i++)
       sum += cache.phi<-1>(x / primes[i], i - 1);
-  }
+
+    return sum;
+  });
 
   return sum;
 }
@@ -8,18 +8,31 @@
 ///
 
 #include "print.hpp"
+#include "primecount.hpp"
 #include "primecount-internal.hpp"
 #include "int128_t.hpp"
 #include <stdint.h>
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <iomanip>
+#include <mutex>
+#include <utility>
 
 namespace {
 
 bool print_ = false;
 bool print_variables_ = false;
 
+/// The progress callback is replaced and copied (see
+/// ProgressReporter) while holding progress_mutex_,
+/// the callback is also executed while holding it.
+///
+std::shared_ptr<const std::function<void(const primecount::Progress&)>> progress_callback_;
+double progress_interval_ = 1.0;
+std::mutex progress_mutex_;
+
 bool is_print_variables()
 {
   return print_variables_;
@@ -58,6 +71,56 @@ void set_print_variables(bool print_variables)
   print_variables_ = print_variables;
 }
 
+void set_progress_callback(std::function<void(const Progress&)> callback,
+                           double interval)
+{
+  std::shared_ptr<const std::function<void(const Progress&)>> ptr;
+  if (callback)
+    ptr = std::make_shared<const std::function<void(const Progress&)>>(std::move(callback));
+
+  std::lock_guard<std::mutex> lock(progress_mutex_);
+  progress_callback_ = std::move(ptr);
+  progress_interval_ = std::max(0.0, interval);
+}
+
+ProgressReporter::ProgressReporter()
+{
+  std::lock_guard<std::mutex> lock(progress_mutex_);
+  callback_ = progress_callback_;
+  interval_ = progress_interval_;
+}
+
+bool ProgressReporter::is_due(double& time) const
+{
+  if (!callback_)
+    return false;
+
+  double now = get_time();
+  if (now - time < interval_)
+    return false;
+
+  time = now;
+  return true;
+}
+
+void ProgressReporter::report(const Progress& progress) const
+{
+  std::unique_lock<std::mutex> lock(progress_mutex_, std::try_to_lock);
+
+  if (lock.owns_lock())
+    (*callback_)(progress);
+}
+
+/// Estimate the remaining seconds using the
+/// elapsed time and the current percentage.
+///
+double get_remaining_secs(double start_time, double percent)
+{
+  percent = in_between(0.01, percent, 100);
+  double secs = get_time() - start_time;
+  return secs * (100 / percent) - secs;
+}
+
 void print_seconds(double seconds)
 {
   std::cout << "Seconds: " << std::fixed << std::setprecision(3) << seconds << std::endl;
@@ -15,6 +15,7 @@
 #include "int128_t.hpp"
 #include "imath.hpp"
 #include "macros.hpp"
+#include "PhiTiny.hpp"
 #include "to_string.hpp"
 
 #include <algorithm>
@@ -42,6 +43,14 @@ double alpha_y_ = -1;
 // Tuning factor used in Xavier Gourdon's algorithm
 double alpha_z_ = -1;
 
+// Settings of the current pi(x, config) computation
+// of this thread, nullptr if none.
+thread_local const primecount::Config* config_ = nullptr;
+
+// Cancellation token of the current pi_async()
+// computation of this thread, nullptr if none.
+thread_local const primecount::CancellationToken* token_ = nullptr;
+
 /// Truncate a floating point number to 3 digits after the decimal
 /// point. This function is used limit the number of digits after the
 /// decimal point of the alpha tuning factor in order to make it more
@@ -144,9 +153,13 @@ int get_status_precision(maxint_t x)
   return max(status_precision_, 0);
 }
 
+/// If precision < 0 the default precision is used
 void set_status_precision(int precision)
 {
-  status_precision_ = in_between(0, precision, 5);
+  if (precision < 0)
+    status_precision_ = -1;
+  else
+    status_precision_ = min(precision, 5);
 }
 
 /// Get the time in seconds (with microsecond accuracy).
@@ -195,6 +208,44 @@ void set_alpha_z(double alpha_z)
     alpha_z_ = truncate3(alpha_z);
 }
 
+ConfigGuard::ConfigGuard(const Config& config)
+  : prev_(config_)
+{
+  config_ = &config;
+}
+
+ConfigGuard::~ConfigGuard()
+{
+  config_ = prev_;
+}
+
+const Config* get_config()
+{
+  return config_;
+}
+
+CancellationGuard::CancellationGuard(const CancellationToken& token)
+  : prev_(token_)
+{
+  token_ = &token;
+}
+
+CancellationGuard::~CancellationGuard()
+{
+  token_ = prev_;
+}
+
+const CancellationToken* get_cancellation_token()
+{
+  return token_;
+}
+
+void check_cancelled()
+{
+  if (token_ && token_->is_cancelled())
+    throw primecount_error("computation has been cancelled");
+}
+
 /// Tuning factor used in the Lagarias-Miller-Odlyzko
 /// and Deleglise-Rivat algorithms.
 ///
@@ -252,6 +303,8 @@ double get_alpha_z(int64_t y, int64_t z)
 double get_alpha_lmo(maxint_t x)
 {
   double alpha = alpha_;
+  if (config_ && config_->alpha >= 1)
+    alpha = truncate3(config_->alpha);
   double x16 = (double) iroot<6>(x);
 
   // use default alpha if no command-line alpha provided
@@ -280,6 +333,8 @@ double get_alpha_lmo(maxint_t x)
 double get_alpha_deleglise_rivat(maxint_t x)
 {
   double alpha = alpha_;
+  if (config_ && config_->alpha >= 1)
+    alpha = truncate3(config_->alpha);
   double x16 = (double) iroot<6>(x);
 
   // Use default alpha
@@ -330,6 +385,10 @@ std::pair<double, double> get_alpha_gourdon(maxint_t x)
 {
   double alpha_y = alpha_y_;
   double alpha_z = alpha_z_;
+  if (config_ && config_->alpha_y >= 1)
+    alpha_y = truncate3(config_->alpha_y);
+  if (config_ && config_->alpha_z >= 1)
+    alpha_z = truncate3(config_->alpha_z);
   double x16 = (double) iroot<6>(x);
   double logx = std::log((double) x);
   double alpha_yz;
@@ -402,6 +461,47 @@ std::pair<double, double> get_alpha_gourdon(maxint_t x)
   return std::make_pair(alpha_y, alpha_z);
 }
 
+/// y = x^(1/3) * alpha, z = x / y and c = PhiTiny::get_c(y)
+/// of the Deleglise-Rivat algorithm.
+///
+DelegliseRivatVars get_deleglise_rivat_vars(maxint_t x)
+{
+  double alpha = get_alpha_deleglise_rivat(x);
+  int64_t y = (int64_t) (iroot<3>(x) * alpha);
+  int64_t z = (int64_t) (x / y);
+  int64_t c = PhiTiny::get_c(y);
+
+  return DelegliseRivatVars{y, z, c};
+}
+
+/// y = x^(1/3) * alpha_y, z = y * alpha_z and
+/// k = PhiTiny::get_k(x) of Xavier Gourdon's algorithm.
+///
+GourdonVars get_gourdon_vars(maxint_t x)
+{
+  auto alpha = get_alpha_gourdon(x);
+  double alpha_y = alpha.first;
+  double alpha_z = alpha.second;
+  int64_t x13 = iroot<3>(x);
+  int64_t sqrtx = isqrt(x);
+  int64_t y = (int64_t)(x13 * alpha_y);
+
+  // x^(1/3) < y < x^(1/2)
+  y = std::max(y, x13 + 1);
+  y = std::min(y, sqrtx - 1);
+  y = std::max(y, (int64_t) 1);
+
+  int64_t k = PhiTiny::get_k(x);
+  int64_t z = (int64_t)(y * alpha_z);
+
+  // y <= z < x^(1/2)
+  z = std::max(z, y);
+  z = std::min(z, sqrtx - 1);
+  z = std::max(z, (int64_t) 1);
+
+  return GourdonVars{y, z, k};
+}
+
 /// x_star = max(x^(1/4), x / y^2)
 ///
 /// After my implementation of Xavier Gourdon's algorithm worked for
@@ -9,6 +9,7 @@
 ///
 
 #include "primecount.hpp"
+#include "int128_t.hpp"
 
 #include <stdint.h>
 #include <iostream>
@@ -53,6 +54,34 @@ int main()
   std::cout << "pi(" << in << ") = " << out;
   check(out == "37607912018");
 
+  in = "455052511";
+  out = nth_prime(in);
+  std::cout << "nth_prime(" << in << ") = " << out;
+  check(out == "9999999967");
+
+#if defined(HAVE_INT128_T)
+  // 216289611853439384 is the number of primes < 2^63 which
+  // is the largest n supported by the 64-bit nth_prime(n).
+  // 2^63 + 29 is the smallest prime > 2^63.
+  in = "216289611853439385";
+  out = nth_prime(in);
+  std::cout << "nth_prime(" << in << ") = " << out;
+  check(out == "9223372036854775837");
+
+  // 425656284035217743 is the number of primes < 2^64,
+  // 2^64 - 59 is the largest prime < 2^64 and
+  // 2^64 + 13 is the smallest prime > 2^64.
+  in = "425656284035217743";
+  out = nth_prime(in);
+  std::cout << "nth_prime(" << in << ") = " << out;
+  check(out == "18446744073709551557");
+
+  in = "425656284035217744";
+  out = nth_prime(in);
+  std::cout << "nth_prime(" << in << ") = " << out;
+  check(out == "18446744073709551629");
+#endif
+
   std::cout << std::endl;
   std::cout << "All tests passed successfully!" << std::endl;
 
@@ -52,6 +52,11 @@ int main()
   std::cout << "primecount_pi_str(" << in << ") = " << out;
   check(std::string(out) == "37607912018");
 
+  in = "455052511";
+  primecount_nth_prime_str(in, out, 32);
+  std::cout << "primecount_nth_prime_str(" << in << ") = " << out;
+  check(std::string(out) == "9999999967");
+
   std::cout << std::endl;
   std::cout << "All tests passed successfully!" << std::endl;
 
@@ -0,0 +1,89 @@
+///
+/// @file   api_config.cpp
+/// @brief  Test primecount's C++ API functions that take a
+///         Config parameter. Computations with different
+///         settings run concurrently and must all return
+///         the correct result.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "primecount.hpp"
+
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  Config config;
+  config.threads = 2;
+  config.alpha_y = 3.5;
+  config.alpha_z = 1.5;
+
+  int64_t n = (int64_t) 1e10;
+  int64_t res = pi(n, config);
+  std::cout << "pi(" << n << ", config) = " << res;
+  check(res == 455052511);
+
+  n = 455052511;
+  res = nth_prime(n, config);
+  std::cout << "nth_prime(" << n << ", config) = " << res;
+  check(res == 9999999967);
+
+  n = (int64_t) 1e12;
+  int64_t a = 78498;
+  res = phi(n, a, config);
+  std::cout << "phi(" << n << ", " << a << ", config) = " << res;
+  check(res == 37607833521);
+
+  std::string in("1000000000000");
+  std::string out = pi(in, config);
+  std::cout << "pi(" << in << ", config) = " << out;
+  check(out == "37607912018");
+
+  // Concurrent computations using different settings
+  std::vector<Config> configs(8);
+  std::vector<int64_t> results(configs.size());
+  std::vector<std::thread> threads;
+
+  for (std::size_t i = 0; i < configs.size(); i++)
+  {
+    configs[i].threads = 1 + (int) i % 3;
+    configs[i].alpha_y = 1 + (double) i;
+    configs[i].alpha_z = 1 + (double) i / 4;
+    threads.emplace_back([&, i] {
+      results[i] = pi((int64_t) 1e12, configs[i]);
+    });
+  }
+
+  for (std::thread& thread : threads)
+    thread.join();
+
+  for (std::size_t i = 0; i < configs.size(); i++)
+  {
+    std::cout << "pi(1e12, alpha_y = " << configs[i].alpha_y
+              << ", alpha_z = " << configs[i].alpha_z << ") = " << results[i];
+    check(results[i] == 37607912018);
+  }
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,81 @@
+///
+/// @file   count_primes.cpp
+/// @brief  Test count_primes(a, b) which counts the primes
+///         inside [a, b] using either the sieve of
+///         Eratosthenes or the prime counting function.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "primecount.hpp"
+#include "primecount.h"
+#include "int128_t.hpp"
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<int64_t> dist(0, (int64_t) 1e12);
+
+  // Short intervals are counted using the sieve of
+  // Eratosthenes, long intervals using pi(x).
+  for (int64_t max_dist : { (int64_t) 1e3, (int64_t) 1e7, (int64_t) 1e12 })
+  {
+    for (int i = 0; i < 20; i++)
+    {
+      int64_t a = dist(gen);
+      int64_t b = a + dist(gen) % max_dist;
+      int64_t res = count_primes(a, b);
+      std::cout << "count_primes(" << a << ", " << b << ") = " << res;
+      check(res == pi(b) - pi(a - 1));
+    }
+  }
+
+  int64_t res = count_primes(1000, 100);
+  std::cout << "count_primes(1000, 100) = " << res;
+  check(res == 0);
+
+  res = count_primes(-10, 2);
+  std::cout << "count_primes(-10, 2) = " << res;
+  check(res == 1);
+
+  res = primecount_count_primes(2, (int64_t) 1e10);
+  std::cout << "primecount_count_primes(2, 10^10) = " << res;
+  check(res == 455052511);
+
+  std::string out = count_primes("1000000000000", "1000001000000");
+  std::cout << "count_primes(10^12, 10^12 + 10^6) = " << out;
+  check(out == std::to_string(pi((int64_t) 1000001000000) - pi((int64_t) 999999999999)));
+
+#if defined(HAVE_INT128_T)
+  // 2^64 - 59, 2^64 - 83 and 2^64 - 95 are the
+  // 3 largest primes < 2^64. 2^64 + 13, 2^64 + 37
+  // and 2^64 + 51 are the 3 smallest primes > 2^64.
+  out = count_primes("18446744073709551521", "18446744073709551667");
+  std::cout << "count_primes(2^64 - 95, 2^64 + 51) = " << out;
+  check(out == "6");
+#endif
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -44,6 +44,7 @@ int main()
   auto lpf = generate_lpf(z);
   auto mpf = generate_mpf(z);
   auto mu = generate_moebius(z);
+  auto pi = generate_pi(z);
 
   FactorTableD<uint16_t> factorTable(y, z, threads);
   int64_t uint16_max = std::numeric_limits<uint16_t>::max();
@@ -82,12 +83,12 @@ int main()
     // lpf(n) (least prime factor) and mpf(n) (max prime factor)
     // functions. is_leaf(n) returns (with n = to_number(index)):
     //
-    // 1) INT_MAX - 1  if n = 1
-    // 2) INT_MAX      if n is a prime
-    // 3) 0            if n has a prime factor > y
-    // 4) 0            if moebius(n) = 0
-    // 5) lpf - 1      if moebius(n) = 1
-    // 6) lpf          if moebius(n) = -1
+    // 1) INT_MAX - 1        if n = 1
+    // 2) INT_MAX            if n is a prime
+    // 3) 0                  if n has a prime factor > y
+    // 4) 0                  if moebius(n) = 0
+    // 5) pi(lpf) * 2        if moebius(n) = 1
+    // 6) pi(lpf) * 2 + 1    if moebius(n) = -1
 
     if (n == 1)
       check(factorTable.is_leaf(i) == uint16_max - 1);
@@ -96,7 +97,15 @@ int main()
     else if (mu[n] == 0)
       check(factorTable.is_leaf(i) == 0);
     else
-      check(lpf[n] == factorTable.is_leaf(i) + (factorTable.mu(i) == 1));
+    {
+      check(pi[lpf[n]] * 2 + (mu[n] == -1) == factorTable.is_leaf(i));
+
+      // leaf_key(b) < is_leaf(n) <=> lpf(n) > primes[b]
+      int64_t b = pi[lpf[n]];
+      std::cout << "leaf_key(" << b - 1 << ") < is_leaf(" << n << ") <= leaf_key(" << b << ")";
+      check(factorTable.leaf_key(b - 1) < factorTable.is_leaf(i) &&
+            factorTable.leaf_key(b) >= factorTable.is_leaf(i));
+    }
 
     not_coprime:;
   }
@@ -1,17 +1,19 @@
 ///
 /// @file  fast_div.cpp
-/// @brief Test fast_div(x, y) function
+/// @brief Test fast_div(x, y) and fast_div64(x, y) functions
 ///
-/// Copyright (C) 2020 Kim Walisch, <kim.walisch@gmail.com>
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
 ///
 /// This file is distributed under the BSD License. See the COPYING
 /// file in the top level directory.
 ///
 
 #include "fast_div.hpp"
+#include "Divider128.hpp"
 #include "int128_t.hpp"
 
 #include <stdint.h>
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <limits>
@@ -95,6 +97,37 @@ int main()
     check(res == x / y);
   }
 
+  // Test (128-bit / 64-bit) = 64-bit using Divider128,
+  // x / d must be < 2^64.
+  for (int i = 0; i < 10000; i++)
+  {
+    uint64_t d = dist_u64(gen) >> (i % 64);
+    d = std::max(d, (uint64_t) 1);
+    uint128_t x = ((uint128_t) (dist_u64(gen) % d) << 64) | dist_u64(gen);
+    uint64_t res = fast_div64(x, Divider128(d));
+
+    std::cout << "fast_div64(" << x << ", Divider128(" << d << ")) = " << res;
+    check(res == x / d);
+  }
+
+  uint64_t divisors[] = { 1, 2, 3, 7, 1ull << 32, (1ull << 63) - 1, 1ull << 63, ~0ull };
+
+  for (uint64_t d : divisors)
+  {
+    // Largest x with x / d < 2^64
+    uint128_t x = ((uint128_t) d << 64) - 1;
+    uint64_t res = fast_div64(x, Divider128(d));
+
+    std::cout << "fast_div64(" << x << ", Divider128(" << d << ")) = " << res;
+    check(res == x / d);
+
+    x = (uint128_t) d << 32;
+    res = fast_div64(x, Divider128(d));
+
+    std::cout << "fast_div64(" << x << ", Divider128(" << d << ")) = " << res;
+    check(res == x / d);
+  }
+
 #endif
 
   std::cout << std::endl;
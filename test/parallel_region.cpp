@@ -0,0 +1,81 @@
+///
+/// @file  parallel_region.cpp
+/// @brief Test parallel_region() and parallel_sum() including
+///        nested parallel regions. If primecount is compiled
+///        without OpenMP we also test that an exception thrown
+///        by a thread is rethrown after all threads have finished.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "parallel.hpp"
+#include "primecount.hpp"
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <cstdlib>
+#include <thread>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  for (int threads = 1; threads <= 8; threads++)
+  {
+    int64_t sum = parallel_sum<int64_t>(threads, [](int t) { return t + 1; });
+    std::cout << "parallel_sum(" << threads << ") = " << sum;
+    check(sum == threads * (threads + 1) / 2);
+  }
+
+  for (int threads = 1; threads <= 8; threads++)
+  {
+    int64_t sum = parallel_sum<int64_t>(threads, [&](int) {
+      return parallel_sum<int64_t>(threads, [](int t) { return t + 1; });
+    });
+
+    std::cout << "Nested parallel_sum(" << threads << ") = " << sum;
+    check(sum == threads * threads * (threads + 1) / 2);
+  }
+
+#if !defined(_OPENMP)
+  for (int thrower = 0; thrower < 4; thrower++)
+  {
+    std::atomic<int> finished(0);
+    bool caught = false;
+
+    try
+    {
+      parallel_region(4, [&](int t) {
+        if (t == thrower)
+          throw primecount_error("test");
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        finished++;
+      });
+    }
+    catch (primecount_error&)
+    {
+      caught = finished == 3;
+    }
+
+    std::cout << "Exception in thread " << thrower;
+    check(caught);
+  }
+#endif
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,122 @@
+///
+/// @file   pi_async.cpp
+/// @brief  Test pi_async() and its cancellation using
+///         primecount's C++ and C APIs.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "primecount.hpp"
+#include "primecount.h"
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+bool is_cancelled(std::future<int64_t>& future)
+{
+  try
+  {
+    future.get();
+    return false;
+  }
+  catch (const primecount_error&)
+  {
+    return true;
+  }
+}
+
+struct Result
+{
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::string res;
+  bool done = false;
+};
+
+void callback(const char* res, void* data)
+{
+  Result* result = (Result*) data;
+  std::lock_guard<std::mutex> lock(result->mutex);
+  result->res = (res) ? res : "NULL";
+  result->done = true;
+  result->cv.notify_one();
+}
+
+std::string wait(Result& result)
+{
+  std::unique_lock<std::mutex> lock(result.mutex);
+  result.cv.wait(lock, [&] { return result.done; });
+  return result.res;
+}
+
+int main()
+{
+  int64_t n = (int64_t) 1e10;
+  int64_t res = pi_async(n).get();
+  std::cout << "pi_async(" << n << ") = " << res;
+  check(res == 455052511);
+
+  std::string in("1000000000000");
+  std::string out = pi_async(in).get();
+  std::cout << "pi_async(" << in << ") = " << out;
+  check(out == "37607912018");
+
+  CancellationToken token1;
+  token1.cancel();
+  auto future = pi_async((int64_t) 1e15, token1);
+  std::cout << "pi_async(1e15) cancelled before start";
+  check(is_cancelled(future));
+
+  // Cancel a long running computation
+  CancellationToken token2;
+  future = pi_async((int64_t) 1e17, token2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  token2.cancel();
+  std::cout << "pi_async(1e17) cancelled while running";
+  check(is_cancelled(future));
+
+  // The computation of another token is not affected
+  CancellationToken token3;
+  res = pi_async(n, token3).get();
+  std::cout << "pi_async(" << n << ") = " << res;
+  check(res == 455052511);
+
+  Result result1;
+  int ret = primecount_pi_async("1000000000000", nullptr, callback, &result1);
+  out = wait(result1);
+  std::cout << "primecount_pi_async(1000000000000) = " << out;
+  check(ret == 0 && out == "37607912018");
+
+  Result result2;
+  primecount_token* token = primecount_token_create();
+  ret = primecount_pi_async("100000000000000000", token, callback, &result2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  primecount_token_cancel(token);
+  primecount_token_destroy(token);
+  out = wait(result2);
+  std::cout << "primecount_pi_async(100000000000000000) cancelled while running";
+  check(ret == 0 && out == "NULL");
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,88 @@
+///
+/// @file   pi_grid.cpp
+/// @brief  Test pi_grid(x0, step, count, callback) which computes
+///         pi(x0 + i * step) for 0 <= i < count.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "primecount.hpp"
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<int64_t> dist(0, (int64_t) 1e10);
+
+  for (int i = 0; i < 20; i++)
+  {
+    int64_t x0 = dist(gen);
+    int64_t step = 1 + dist(gen) % 1000000;
+    int64_t count = 1 + dist(gen) % 1000;
+    int64_t next = x0;
+    int64_t n = 0;
+    bool OK = true;
+
+    pi_grid(x0, step, count, [&](int64_t x, int64_t pix)
+    {
+      OK = OK && x == next;
+      // Checking every grid point takes too long
+      if (n % 100 == 0 || n == count - 1)
+        OK = OK && pix == pi(x);
+      next += step;
+      n++;
+    });
+
+    std::cout << "pi_grid(" << x0 << ", " << step << ", " << count << ")";
+    check(OK && n == count);
+  }
+
+  // Large steps use the prime counting function
+  int64_t n = 0;
+  pi_grid((int64_t) 1e11, (int64_t) 1e11, 4, [&](int64_t x, int64_t pix)
+  {
+    n++;
+    std::cout << "pi(" << x << ") = " << pix;
+    check(pix == pi(x));
+  });
+
+  n = 0;
+  bool OK = true;
+  pi_grid(0, 1, 1000, [&](int64_t x, int64_t pix)
+  {
+    OK = OK && x == n && pix == pi(x);
+    n++;
+  });
+
+  std::cout << "pi_grid(0, 1, 1000)";
+  check(OK && n == 1000);
+
+  std::string res;
+  pi_grid("1000000000000", "1000000000", 3,
+    [&](const std::string&, const std::string& pix) { res = pix; });
+  std::cout << "pi_grid(10^12, 10^9, 3) = " << res;
+  check(res == "37680293072");
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,77 @@
+///
+/// @file   pi_interval.cpp
+/// @brief  Test pi(x, y) which counts the primes inside ]x, y]
+///         using a segmented sieve of Eratosthenes, this also
+///         works for numbers > 2^64.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "primecount.hpp"
+#include "int128_t.hpp"
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<int64_t> dist(0, (int64_t) 1e10);
+
+  for (int i = 0; i < 100; i++)
+  {
+    int64_t x = dist(gen);
+    int64_t y = x + dist(gen) % 10000000;
+    std::string res = pi(std::to_string(x), std::to_string(y));
+    std::cout << "pi(" << x << ", " << y << ") = " << res;
+    check(res == std::to_string(pi(y) - pi(x)));
+  }
+
+  std::string res = pi("1000", "100");
+  std::cout << "pi(1000, 100) = " << res;
+  check(res == "0");
+
+#if defined(HAVE_INT128_T)
+  // 2^64 - 59, 2^64 - 83 and 2^64 - 95 are the
+  // 3 largest primes < 2^64. 2^64 + 13, 2^64 + 37
+  // and 2^64 + 51 are the 3 smallest primes > 2^64.
+  std::string x = "18446744073709551520";
+  std::string y = "18446744073709551667";
+  res = pi(x, y);
+  std::cout << "pi(2^64 - 96, 2^64 + 51) = " << res;
+  check(res == "6");
+
+  x = "18446744073709551616";
+  y = "18446744073709551652";
+  res = pi(x, y);
+  std::cout << "pi(2^64, 2^64 + 36) = " << res;
+  check(res == "1");
+
+  x = "100000000000000000000";
+  y = "100000000000001000000";
+  res = pi(x, y);
+  std::cout << "pi(10^20, 10^20 + 10^6) = " << res;
+  check(res == "21632");
+#endif
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
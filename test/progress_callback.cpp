@@ -0,0 +1,68 @@
+///
+/// @file   progress_callback.cpp
+/// @brief  Test that the progress callback receives the
+///         progress of the A, B, C and D formulas.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "primecount.hpp"
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  std::set<std::string> formulas;
+  bool OK = true;
+
+  // Report the progress as often as possible
+  set_progress_callback([&](const Progress& progress) {
+    formulas.insert(progress.formula);
+    OK &= progress.percent >= 0;
+    OK &= progress.percent <= 100;
+    OK &= progress.remaining_secs >= 0;
+    if (progress.formula == "D")
+      OK &= !progress.sum.empty();
+  }, 0);
+
+  int64_t n = (int64_t) 1e13;
+  int64_t res = pi(n);
+  std::cout << "pi(" << n << ") = " << res;
+  check(res == 346065536839);
+
+  std::cout << "Progress values are valid";
+  check(OK);
+
+  for (std::string formula : { "AC", "B", "D" })
+  {
+    std::cout << "Progress of " << formula << " reported";
+    check(formulas.count(formula) == 1);
+  }
+
+  set_progress_callback(nullptr);
+  formulas.clear();
+  res = pi(n);
+  std::cout << "pi(" << n << ") without progress callback = " << res;
+  check(res == 346065536839 && formulas.empty());
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
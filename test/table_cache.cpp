@@ -0,0 +1,139 @@
+///
+/// @file  table_cache.cpp
+/// @brief Test that the PiTable and FactorTableD lookup tables
+///        that are loaded from the table cache directory (or from
+///        the memory table cache) are identical to the generated
+///        lookup tables.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "primecount.hpp"
+#include "primecount-internal.hpp"
+#include "FactorTableD.hpp"
+#include "PiTable.hpp"
+#include "TableCache.hpp"
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  int threads = get_num_threads();
+  int64_t y = 100000;
+  int64_t z = 20000000;
+
+  set_table_cache_dir("");
+  PiTable pi1(z, threads);
+  FactorTableD<uint16_t> factor1(y, z, threads);
+
+  // 1st iteration generates and saves the tables,
+  // 2nd iteration loads the tables from the files.
+  for (int i = 0; i < 2; i++)
+  {
+    set_table_cache_dir(".");
+    PiTable pi2(z, threads);
+    FactorTableD<uint16_t> factor2(y, z, threads);
+
+    std::cout << "PiTable cache test " << i;
+    bool OK = true;
+    for (int64_t n = 0; n <= z; n += 7)
+      OK &= (pi1[n] == pi2[n]);
+    check(OK);
+
+    std::cout << "FactorTableD cache test " << i;
+    OK = true;
+    for (int64_t n = 1; n <= z; n += 2)
+    {
+      int64_t index = factor1.to_index(n);
+      OK &= (factor1.is_leaf(index) == factor2.is_leaf(index));
+    }
+    check(OK);
+  }
+
+  // 1st iteration generates the tables and moves them into
+  // the memory table cache, 2nd iteration reuses them.
+  set_table_cache_dir("");
+  set_memory_table_cache(true);
+
+  for (int i = 0; i < 2; i++)
+  {
+    PiTable pi2(z - i * 1000, threads);
+    FactorTableD<uint16_t> factor2(y, z - i * 1000, threads);
+
+    std::cout << "PiTable memory cache test " << i;
+    bool OK = true;
+    for (int64_t n = 0; n <= z - i * 1000; n += 7)
+      OK &= (pi1[n] == pi2[n]);
+    check(OK);
+
+    std::cout << "FactorTableD memory cache test " << i;
+    OK = true;
+    for (int64_t n = 1; n <= z - i * 1000; n += 2)
+    {
+      int64_t index = factor1.to_index(n);
+      OK &= (factor1.is_leaf(index) == factor2.is_leaf(index));
+    }
+    check(OK);
+  }
+
+  set_memory_table_cache(false);
+
+  // primecount --server enables the memory table cache,
+  // hence a 2nd identical query must load its lookup
+  // tables from memory instead of generating them.
+  set_memory_table_cache(true);
+  {
+    uint64_t size = (z + 1 + 239) / 240;
+    TableHeader header(240, 16, z, size);
+    TableFile file1;
+
+    std::cout << "PiTable not cached before 1st query";
+    check(file1.open("PiTable.bin", header) == nullptr);
+
+    PiTable pi2(z, threads);
+    TableFile file2;
+    std::cout << "PiTable reused by 2nd query";
+    check(file2.open("PiTable.bin", header) != nullptr);
+
+    PiTable pi3(z, threads);
+    std::cout << "PiTable of 2nd query";
+    check(pi3[z] == pi1[z]);
+  }
+  set_memory_table_cache(false);
+
+  // Saving to a directory that does not exist
+  // must not throw an exception.
+  set_table_cache_dir("");
+  Config config;
+  config.table_cache_dir = "primecount-missing-dir";
+  {
+    ConfigGuard guard(config);
+    PiTable pi3(z, threads);
+    std::cout << "Table cache dir missing test";
+    check(pi3[z] == pi1[z]);
+  }
+
+  std::remove("PiTable.bin");
+  std::remove("FactorTableD16.bin");
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
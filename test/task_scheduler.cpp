@@ -0,0 +1,84 @@
+///
+/// @file  task_scheduler.cpp
+/// @brief Test that the TaskScheduler hands out each outer loop
+///        iteration b and each of its inner loop iterations
+///        exactly once.
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "TaskScheduler.hpp"
+#include "pod_vector.hpp"
+
+#include <stdint.h>
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<int64_t> dist_b(1, 1000);
+  std::uniform_int_distribution<int> dist_threads(1, 256);
+
+  for (int j = 0; j < 20; j++)
+  {
+    int64_t max_b = dist_b(gen);
+    int64_t max_i = max_b * 10;
+    int threads = dist_threads(gen);
+    TaskScheduler scheduler;
+
+    // Inner loop: b + 1 <= i < max_i / b, the
+    // first iterations are the most expensive.
+    for (int64_t b = 1; b <= max_b; b++)
+      scheduler.add(b, b + 1, max_i / b, 1e6 / b);
+
+    scheduler.split(threads);
+    pod_vector<int64_t> count_b(max_b + 1);
+    pod_vector<int64_t> count_i((max_b + 1) * max_i);
+    std::fill(count_b.begin(), count_b.end(), 0);
+    std::fill(count_i.begin(), count_i.end(), 0);
+
+    for (Task task; scheduler.get_task(task);)
+    {
+      if (task.start == task.b + 1)
+        count_b[task.b]++;
+      for (int64_t i = task.start; i < task.stop; i++)
+        count_i[task.b * max_i + i]++;
+    }
+
+    std::cout << "TaskScheduler(max_b = " << max_b << ", threads = " << threads << ")";
+    bool OK = true;
+
+    for (int64_t b = 1; b <= max_b; b++)
+    {
+      OK &= (count_b[b] == 1);
+      for (int64_t i = 0; i < max_i; i++)
+      {
+        bool is_inner = (i >= b + 1 && i < max_i / b);
+        OK &= (count_i[b * max_i + i] == (is_inner ? 1 : 0));
+      }
+    }
+
+    check(OK);
+  }
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,80 @@
+///
+/// @file  update_phi.cpp
+/// @brief Test that update_phi(x, a) only recomputes the phi[i]
+///        values outside of the [min_i, max_i[ range and that
+///        its results are identical to generate_phi(x, a).
+///
+/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include "primecount.hpp"
+#include "generate.hpp"
+#include "generate_phi.hpp"
+#include "PiTable.hpp"
+#include "pod_vector.hpp"
+
+#include <stdint.h>
+#include <iostream>
+#include <random>
+
+using std::size_t;
+using namespace primecount;
+
+int main()
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  for (int j = 0; j < 100; j++)
+  {
+    std::uniform_int_distribution<int64_t> dist(0, 1000000);
+
+    int64_t x = dist(gen);
+    int64_t y = isqrt(x) + 1000;
+
+    int threads = 1;
+    PiTable pi(y, threads);
+    int64_t a = pi[y];
+
+    auto primes = generate_primes<int64_t>(y);
+    auto phi1 = generate_phi(x, a, primes, pi);
+
+    std::uniform_int_distribution<int64_t> dist_i(0, a + 1);
+    int64_t min_i = dist_i(gen);
+    int64_t max_i = dist_i(gen);
+
+    // Only phi[i] with min_i <= i < max_i are correct
+    pod_vector<int64_t> phi2(phi1.size());
+    for (size_t i = 0; i < phi2.size(); i++)
+    {
+      if ((int64_t) i >= min_i && (int64_t) i < max_i)
+        phi2[i] = phi1[i];
+      else
+        phi2[i] = -1;
+    }
+
+    update_phi(x, a, primes, pi, phi2, min_i, max_i);
+
+    for (size_t i = 1; i < phi1.size(); i++)
+    {
+      if (phi1[i] != phi2[i])
+      {
+        std::cerr << "Error: update_phi(x, i - 1) = " << phi2[i] << std::endl;
+        std::cerr << "Correct: generate_phi(x, i - 1) = " << phi1[i] << std::endl;
+        std::cerr << "x = " << x << std::endl;
+        std::cerr << "i - 1 = " << i - 1 << std::endl;
+        std::cerr << "min_i = " << min_i << std::endl;
+        std::cerr << "max_i = " << max_i << std::endl;
+        std::exit(1);
+      }
+    }
+  }
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}